@@ -0,0 +1,267 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace task_scheduler {
+
+	// The days of one year, one bit per day of the year, from bit 0 of words[0].
+	// The bits past the end of the year are always clear.
+	struct YearBitmap
+	{
+		int32_t firstDay; // Days since 1970-01-01 of January 1st
+		int32_t length; // 365 or 366
+		uint64_t words[6];
+	};
+
+	// Get the index of the lowest set bit, which must exist
+	static uint32_t FindLowestSetBit(uint64_t value)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return index;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanForward(&index, (unsigned long)value)) {
+			return index;
+		}
+		_BitScanForward(&index, (unsigned long)(value >> 32));
+		return index + 32;
+#else
+		return (uint32_t)__builtin_ctzll(value);
+#endif
+	}
+
+	struct BlackoutCalendar::Impl
+	{
+		// The year of years[0], the years in between are contiguous
+		uint16_t firstYear;
+		std::vector<YearBitmap> years;
+
+		Impl() : firstYear(0)
+		{
+		}
+
+		// Get the index of the year holding a day, or -1 before the first year, or years.size() after the last
+		ptrdiff_t FindYear(int32_t day) const
+		{
+			if (years.empty() || day < years.front().firstDay) {
+				return -1;
+			}
+			if (day - years.back().firstDay >= years.back().length) {
+				return (ptrdiff_t)years.size();
+			}
+			return (ptrdiff_t)DaysToDate(day).GetYear() - firstYear;
+		}
+
+		// Get the bitmap for a year, adding it (and any years in between) if necessary
+		YearBitmap &AddYear(uint16_t year)
+		{
+			if (years.empty()) {
+				firstYear = year;
+			}
+			while (year < firstYear) {
+				years.insert(years.begin(), MakeYear(--firstYear));
+			}
+			while (year >= firstYear + years.size()) {
+				years.push_back(MakeYear((uint16_t)(firstYear + years.size())));
+			}
+			return years[year - firstYear];
+		}
+
+		static YearBitmap MakeYear(uint16_t year)
+		{
+			YearBitmap bitmap = {};
+			bitmap.firstDay = DateToDays(DateSpec(year, 0, 0));
+			bitmap.length = IsLeapYear(year) ? 366 : 365;
+			return bitmap;
+		}
+
+		void SetDays(const DateSpec &first, const DateSpec &last, bool blackedOut)
+		{
+			if (!first.GetYear() || !last.GetYear()) {
+				return;
+			}
+
+			int32_t end = DateToDays(last) + 1;
+			for (int32_t day = DateToDays(first); day < end; day++) {
+				ptrdiff_t index = FindYear(day);
+				if (blackedOut && (index < 0 || index >= (ptrdiff_t)years.size())) {
+					AddYear(DaysToDate(day).GetYear());
+					index = FindYear(day);
+				} else if (index < 0 || index >= (ptrdiff_t)years.size()) {
+					continue;
+				}
+
+				YearBitmap &year = years[index];
+				uint32_t bit = (uint32_t)(day - year.firstDay);
+				if (blackedOut) {
+					year.words[bit / 64] |= 1ull << (bit % 64);
+				} else {
+					year.words[bit / 64] &= ~(1ull << (bit % 64));
+				}
+			}
+		}
+	};
+
+	BlackoutCalendar::BlackoutCalendar() : impl(new Impl())
+	{
+	}
+
+	BlackoutCalendar::~BlackoutCalendar()
+	{
+		delete impl;
+	}
+
+	void BlackoutCalendar::AddDays(const DateSpec &first, const DateSpec &last)
+	{
+		impl->SetDays(first, last, true);
+	}
+
+	void BlackoutCalendar::RemoveDays(const DateSpec &first, const DateSpec &last)
+	{
+		impl->SetDays(first, last, false);
+	}
+
+	void BlackoutCalendar::Clear()
+	{
+		impl->years.clear();
+		impl->firstYear = 0;
+	}
+
+	bool BlackoutCalendar::IsBlackedOut(int32_t day) const
+	{
+		ptrdiff_t index = impl->FindYear(day);
+		if (index < 0 || index >= (ptrdiff_t)impl->years.size()) {
+			return false;
+		}
+
+		const YearBitmap &year = impl->years[index];
+		uint32_t bit = (uint32_t)(day - year.firstDay);
+		return ((year.words[bit / 64] >> (bit % 64)) & 1) != 0;
+	}
+
+	int32_t BlackoutCalendar::GetNextAllowedDay(int32_t day) const
+	{
+		ptrdiff_t index = impl->FindYear(day);
+		if (index < 0) {
+			return day;
+		}
+
+		for (; index < (ptrdiff_t)impl->years.size(); index++) {
+			const YearBitmap &year = impl->years[index];
+			if (day < year.firstDay) {
+				day = year.firstDay;
+			}
+
+			// Look for a clear bit, a word at a time
+			uint32_t bit = (uint32_t)(day - year.firstDay);
+			while (bit < (uint32_t)year.length) {
+				uint64_t allowed = ~year.words[bit / 64] >> (bit % 64);
+				if (allowed) {
+					bit += FindLowestSetBit(allowed);
+					break;
+				}
+				bit = (bit / 64 + 1) * 64;
+			}
+			if (bit < (uint32_t)year.length) {
+				return year.firstDay + (int32_t)bit;
+			}
+			day = year.firstDay + year.length;
+		}
+		return day;
+	}
+
+	int32_t BlackoutCalendar::GetNextBlackedOutDay(int32_t day, int32_t endDay) const
+	{
+		ptrdiff_t index = impl->FindYear(day);
+		if (index < 0) {
+			index = 0;
+		}
+
+		for (; index < (ptrdiff_t)impl->years.size() && day < endDay; index++) {
+			const YearBitmap &year = impl->years[index];
+			if (day < year.firstDay) {
+				day = year.firstDay;
+			}
+
+			// Look for a set bit, a word at a time
+			uint32_t bit = (uint32_t)(day - year.firstDay);
+			while (bit < (uint32_t)year.length) {
+				uint64_t blackedOut = year.words[bit / 64] >> (bit % 64);
+				if (blackedOut) {
+					int32_t found = year.firstDay + (int32_t)(bit + FindLowestSetBit(blackedOut));
+					return found < endDay ? found : endDay;
+				}
+				bit = (bit / 64 + 1) * 64;
+			}
+			day = year.firstDay + year.length;
+		}
+		return endDay;
+	}
+
+	uint64_t BlackoutCalendar::GetContentHash() const
+	{
+		// FNV-1a of the blacked out words, skipping empty years so that removing days always
+		// gives the same hash as never having added them
+		uint64_t hash = 14695981039346656037ull;
+		for (const YearBitmap &year : impl->years) {
+			uint64_t any = 0;
+			for (uint64_t word : year.words) {
+				any |= word;
+			}
+			if (!any) {
+				continue;
+			}
+
+			const uint8_t *bytes = (const uint8_t *)&year;
+			for (size_t i = 0; i < sizeof(year); i++) {
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			}
+		}
+		return hash;
+	}
+
+	// Move a next run time off blacked out days, stopping at the end day of the schedule
+	static int64_t SkipBlackoutDays(const BlackoutCalendar &calendar, int64_t nextRun, int32_t endDay)
+	{
+		if (nextRun == NO_NEXT_RUN) {
+			return NO_NEXT_RUN;
+		}
+
+		int64_t day = nextRun / SECONDS_PER_DAY;
+		if (nextRun < 0 && day * SECONDS_PER_DAY != nextRun) {
+			day--;
+		}
+		if (!calendar.IsBlackedOut((int32_t)day)) {
+			return nextRun;
+		}
+
+		int32_t allowedDay = calendar.GetNextAllowedDay((int32_t)day);
+		if (allowedDay >= endDay) {
+			return NO_NEXT_RUN;
+		}
+		return nextRun + (int64_t)(allowedDay - day) * SECONDS_PER_DAY;
+	}
+
+	TASKSCHEDULER_EXPORT int64_t GetNextDailyRun(const DateSpec &startDate, const DateSpec &endDate,
+		const TimeSpec &dailyStartTime, int64_t now, const BlackoutCalendar &calendar)
+	{
+		return SkipBlackoutDays(calendar, GetNextDailyRun(startDate, endDate, dailyStartTime, now),
+			endDate.GetYear() ? DateToDays(endDate) : NO_END_DAY);
+	}
+
+	TASKSCHEDULER_EXPORT void SkipBlackoutDays(const DailyScheduleColumns &schedules,
+		const BlackoutCalendar *const *calendars, int64_t *nextRuns)
+	{
+		for (size_t i = 0; i < schedules.count; i++) {
+			if (calendars[i]) {
+				nextRuns[i] = SkipBlackoutDays(*calendars[i], nextRuns[i], schedules.endDays[i]);
+			}
+		}
+	}
+
+}
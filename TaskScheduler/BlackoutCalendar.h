@@ -0,0 +1,87 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * A set of days on which daily tasks don't run, e.g. holidays and change freezes.
+	 * Days are stored as a 366-bit bitmap per year, so testing a day is a couple of lookups, and
+	 * finding the next day that isn't blacked out skips 64 days at a time.
+	 * A calendar is shared by every task it is attached to (see TaskDefinition::SetBlackoutCalendar),
+	 * so attaching it costs nothing per task. It must not be modified while tasks that use it are
+	 * being registered or their next runs computed.
+	 */
+	class TASKSCHEDULER_EXPORT BlackoutCalendar
+	{
+		struct Impl;
+		Impl *impl;
+
+	public:
+		BlackoutCalendar();
+		~BlackoutCalendar();
+
+		BlackoutCalendar(const BlackoutCalendar &) = delete;
+		BlackoutCalendar &operator=(const BlackoutCalendar &) = delete;
+
+		/**
+		 * Black out a range of days
+		 * @param first The first day, which must have a non-zero year
+		 * @param last The last day, inclusive. Nothing is changed if this is before the first day.
+		 */
+		void AddDays(const DateSpec &first, const DateSpec &last);
+
+		/**
+		 * Allow tasks to run again on a range of days
+		 * @param first The first day, which must have a non-zero year
+		 * @param last The last day, inclusive
+		 */
+		void RemoveDays(const DateSpec &first, const DateSpec &last);
+
+		/**
+		 * Remove all days
+		 */
+		void Clear();
+
+		/**
+		 * Test if a day is blacked out
+		 * @param day The day, as days since 1970-01-01 (see DateToDays)
+		 */
+		bool IsBlackedOut(int32_t day) const;
+
+		/**
+		 * Get the first day at or after the given day that is not blacked out
+		 * @param day The day, as days since 1970-01-01
+		 */
+		int32_t GetNextAllowedDay(int32_t day) const;
+
+		/**
+		 * Get the first day at or after the given day that is blacked out
+		 * @param day The day, as days since 1970-01-01
+		 * @param endDay The day to stop searching at
+		 * @returns The blacked out day, or endDay if there are none before it
+		 */
+		int32_t GetNextBlackedOutDay(int32_t day, int32_t endDay) const;
+
+		/**
+		 * Get a hash of the days in the calendar, which changes whenever days are added or removed
+		 */
+		uint64_t GetContentHash() const;
+	};
+
+	/**
+	 * Get the next time a daily schedule runs, at or after the given time, skipping blacked out days
+	 * @see GetNextDailyRun
+	 */
+	TASKSCHEDULER_EXPORT int64_t GetNextDailyRun(const DateSpec &startDate, const DateSpec &endDate,
+		const TimeSpec &dailyStartTime, int64_t now, const BlackoutCalendar &calendar);
+
+	/**
+	 * Move next run times, as computed by GetNextDailyRuns, off blacked out days.
+	 * Schedules without a calendar are left as they are, so this costs one test per schedule that has one.
+	 * @param schedules The packed schedules
+	 * @param calendars The calendar of each schedule, or NULL, must have schedules.count values
+	 * @param nextRuns [in, out] The next run time of each schedule, or NO_NEXT_RUN
+	 */
+	TASKSCHEDULER_EXPORT void SkipBlackoutDays(const DailyScheduleColumns &schedules,
+		const BlackoutCalendar *const *calendars, int64_t *nextRuns);
+
+}
@@ -0,0 +1,40 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+namespace task_scheduler {
+
+	TASKSCHEDULER_EXPORT int64_t GetWallClockMs()
+	{
+		FILETIME now;
+		GetSystemTimePreciseAsFileTime(&now);
+		// FILETIME counts 100ns intervals since 1601-01-01
+		uint64_t ticks = ((uint64_t)now.dwHighDateTime << 32) | now.dwLowDateTime;
+		return (int64_t)((ticks - 116444736000000000ull) / 10000);
+	}
+
+	TASKSCHEDULER_EXPORT ClockReading ReadClocks()
+	{
+		ClockReading reading;
+		reading.wallMs = GetWallClockMs();
+		reading.tickMs = GetTickCount64();
+		ULONGLONG unbiased = 0;
+		QueryUnbiasedInterruptTime(&unbiased);
+		// The unbiased interrupt time counts 100ns intervals
+		reading.unbiasedMs = unbiased / 10000;
+		return reading;
+	}
+
+	TASKSCHEDULER_EXPORT bool ClassifyClockJump(const ClockReading &last, const ClockReading &now,
+		int64_t &stepped, int64_t &suspended, int64_t &from, int64_t &to)
+	{
+		int64_t elapsed = (int64_t)(now.tickMs - last.tickMs);
+		int64_t awake = (int64_t)(now.unbiasedMs - last.unbiasedMs);
+		stepped = (now.wallMs - last.wallMs) - elapsed;
+		suspended = elapsed - awake;
+		from = last.wallMs + awake;
+		to = now.wallMs;
+		return stepped <= -CLOCK_JUMP_TOLERANCE_MS || stepped >= CLOCK_JUMP_TOLERANCE_MS ||
+			suspended >= CLOCK_JUMP_TOLERANCE_MS;
+	}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * Steps of the wall clock, or suspends, shorter than this are taken to be drift corrections and
+	 * scheduling delays (see ClassifyClockJump)
+	 */
+	static const int64_t CLOCK_JUMP_TOLERANCE_MS = 2000;
+
+	/**
+	 * A reading of the wall clock and of two monotonic clocks, to tell when the wall clock was changed
+	 * or the machine was suspended between two readings
+	 */
+	struct ClockReading
+	{
+		int64_t wallMs;			// The wall clock, which steps when the time is changed (see GetWallClockMs)
+		uint64_t tickMs;		// Monotonic, including time suspended
+		uint64_t unbiasedMs;	// Monotonic, excluding time suspended
+	};
+
+	/**
+	 * Get the current wall clock time, in milliseconds since 1970-01-01 UTC (the same epoch as time_t)
+	 */
+	TASKSCHEDULER_EXPORT int64_t GetWallClockMs();
+
+	/**
+	 * Read all three clocks
+	 */
+	TASKSCHEDULER_EXPORT ClockReading ReadClocks();
+
+	/**
+	 * Find out whether the wall clock was changed, or the machine suspended, between two readings.
+	 * @param last The earlier reading
+	 * @param now The later reading
+	 * @param stepped [out] How far the wall clock was changed, in milliseconds, negative if it was set back
+	 * @param suspended [out] How long the machine was suspended, in milliseconds
+	 * @param from [out] Where the wall clock would be had it only run while awake, in ms since 1970-01-01 UTC
+	 * @param to [out] Where the wall clock is. If to > from the time in between was skipped, and if
+	 * to < from it is repeated.
+	 * @returns true if either the step or the suspend was at least CLOCK_JUMP_TOLERANCE_MS, i.e. times
+	 * computed from the earlier reading are now wrong
+	 */
+	TASKSCHEDULER_EXPORT bool ClassifyClockJump(const ClockReading &last, const ClockReading &now,
+		int64_t &stepped, int64_t &suspended, int64_t &from, int64_t &to);
+
+}
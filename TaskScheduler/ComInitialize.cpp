@@ -9,15 +9,18 @@ namespace task_scheduler {
 		// Initialize COM & Set security levels
 		initResult = CoInitializeEx(NULL, COINITBASE_MULTITHREADED);
 		if (FAILED(initResult)) {
-			printf("Unable to initialize COM: %x\n", initResult);
+			fprintf(stderr, "Unable to initialize COM: %x\n", initResult);
 			return;
 		}
 
 		initialized = true;
 		initResult = CoInitializeSecurity(NULL, -1, NULL, NULL, RPC_C_AUTHN_LEVEL_PKT_PRIVACY,
 			RPC_C_IMP_LEVEL_IMPERSONATE, NULL, 0, NULL);
-		if (FAILED(initResult)) {
-			printf("Unable to initialize security: %x\n", initResult);
+		if (initResult == RPC_E_TOO_LATE) {
+			// Security was already initialized for this process, e.g. by a session that is still open
+			initResult = S_OK;
+		} else if (FAILED(initResult)) {
+			fprintf(stderr, "Unable to initialize security: %x\n", initResult);
 		}
 	}
 
@@ -0,0 +1,101 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+namespace task_scheduler {
+
+	template <typename CharT>
+	static size_t StringLength(const CharT *str)
+	{
+		return std::char_traits<CharT>::length(str);
+	}
+
+	template <typename CharT>
+	static bool ArgumentNeedsQuotes(const CharT *arg, size_t len)
+	{
+		if (len == 0) {
+			return true;
+		}
+		for (size_t i = 0; i < len; i++) {
+			switch (arg[i]) {
+			case ' ': case '\t': case '\n': case '\v': case '"':
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Quoting follows the rules used by CommandLineToArgvW:
+	// Backslashes are literal, unless they immediately precede a double quote,
+	// in which case they must be doubled, and the quote itself escaped.
+	template <typename CharT>
+	static void AppendQuotedArgument(std::basic_string<CharT> &dst, const CharT *arg, size_t len)
+	{
+		if (!ArgumentNeedsQuotes(arg, len)) {
+			dst.append(arg, len);
+			return;
+		}
+
+		dst.push_back('"');
+		size_t backslashes = 0;
+		for (size_t i = 0; i < len; i++) {
+			if (arg[i] == '\\') {
+				backslashes++;
+				continue;
+			}
+
+			if (arg[i] == '"') {
+				// Escape the preceding backslashes, and the quote
+				dst.append(backslashes * 2 + 1, '\\');
+			} else {
+				dst.append(backslashes, '\\');
+			}
+			dst.push_back(arg[i]);
+			backslashes = 0;
+		}
+
+		// Escape trailing backslashes, so they don't escape the closing quote
+		dst.append(backslashes * 2, '\\');
+		dst.push_back('"');
+	}
+
+	template <typename CharT>
+	static void BuildArgumentStringT(std::basic_string<CharT> &dst, const CharT **argv, int32_t argc)
+	{
+		dst.clear();
+		if (!argv || argc <= 0) {
+			return;
+		}
+
+		// Reserve for the worst case up front: every character escaped, plus quotes and a separator
+		size_t capacity = 0;
+		for (int32_t i = 0; i < argc; i++) {
+			if (argv[i]) {
+				capacity += StringLength(argv[i]) * 2 + 3;
+			}
+		}
+		dst.reserve(capacity);
+
+		bool first = true;
+		for (int32_t i = 0; i < argc; i++) {
+			if (!argv[i]) {
+				continue;
+			}
+			if (!first) {
+				dst.push_back(' ');
+			}
+			AppendQuotedArgument(dst, argv[i], StringLength(argv[i]));
+			first = false;
+		}
+	}
+
+	TASKSCHEDULER_EXPORT void BuildArgumentString(std::wstring &dst, const wchar_t **argv, int32_t argc)
+	{
+		BuildArgumentStringT(dst, argv, argc);
+	}
+
+	TASKSCHEDULER_EXPORT void BuildArgumentString(std::string &dst, const char **argv, int32_t argc)
+	{
+		BuildArgumentStringT(dst, argv, argc);
+	}
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * Join an array of arguments into a single command line argument string.
+	 * Each argument is quoted and escaped as necessary, so that the string is split back into
+	 * the same arguments by CommandLineToArgvW and the C runtime.
+	 * NULL arguments are skipped, and empty arguments are written as "".
+	 * @param dst [out] The string to write the arguments into, existing contents are replaced.
+	 * @param argv The array of null-terminated arguments
+	 * @param argc The number of arguments in the argv array
+	 */
+	TASKSCHEDULER_EXPORT void BuildArgumentString(std::wstring &dst, const wchar_t **argv, int32_t argc);
+
+	/**
+	 * Join an array of UTF-8 arguments into a single UTF-8 command line argument string.
+	 * See BuildArgumentString above for a description of the quoting rules.
+	 */
+	TASKSCHEDULER_EXPORT void BuildArgumentString(std::string &dst, const char **argv, int32_t argc);
+
+}
@@ -3,69 +3,32 @@
 
 namespace task_scheduler {
 
-	DateSpec::DateSpec(uint16_t year, uint8_t month, uint8_t day): year(year), month(month), day(day)
-	{ 
-		// Normalize invalid values
-		if (this->month > 11) {
-			this->month = 0;
-		}
-		if (this->day > 30) {
-			this->day = 0;
-		}
-	}
-
-	uint16_t DateSpec::GetYear() const
-	{
-		return year;
-	}
-
-	uint8_t DateSpec::GetMonth() const
-	{
-		return month;
-	}
-
-	uint8_t DateSpec::GetDay() const
-	{
-		return day;
-	}
-
-	static __inline int32_t TimeSpecToSeconds(const TimeSpec &ts) {
-		return (ts.GetHour() * 3600) + (ts.GetMinute() * 60) + ts.GetSecond();
-	}
-
-	TimeSpec::TimeSpec(uint8_t hour, uint8_t minute, uint8_t second): hour(hour), minute(minute), second(second)
-	{
-		if (this->hour > 23) {
-			this->hour = 0;
-		}
-		if (this->minute > 59) {
-			this->minute = 0;
-		}
-		if (this->second > 59) {
-			this->second = 0;
-		}
-	}
-
-	uint8_t TimeSpec::GetHour() const
-	{
-		return hour;
-	}
-
-	uint8_t TimeSpec::GetMinute() const
-	{
-		return minute;
-	}
-
-	uint8_t TimeSpec::GetSecond() const
+	// Conversions between dates and day numbers use the proleptic Gregorian calendar, with
+	// years starting in March so that the leap day is the last day of the year.
+	// See: http://howardhinnant.github.io/date_algorithms.html
+	TASKSCHEDULER_EXPORT int32_t DateToDays(const DateSpec &date)
 	{
-		return second;
+		int32_t month = date.GetMonth() + 1;
+		int32_t year = date.GetYear() - (month <= 2 ? 1 : 0);
+		int32_t era = (year >= 0 ? year : year - 399) / 400;
+		int32_t yearOfEra = year - era * 400;
+		int32_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + date.GetDay();
+		int32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+		return era * 146097 + dayOfEra - 719468;
 	}
 
-	int32_t TimeSpec::operator-(const TimeSpec &rhs) const
+	TASKSCHEDULER_EXPORT DateSpec DaysToDate(int32_t days)
 	{
-		int32_t thisTime = TimeSpecToSeconds(*this);
-		int32_t rhsTime = TimeSpecToSeconds(rhs);
-		return thisTime - rhsTime;
+		days += 719468;
+		int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+		int32_t dayOfEra = days - era * 146097;
+		int32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+		int32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+		int32_t shiftedMonth = (5 * dayOfYear + 2) / 153;
+		int32_t day = dayOfYear - (153 * shiftedMonth + 2) / 5;
+		int32_t month = shiftedMonth < 10 ? shiftedMonth + 2 : shiftedMonth - 10;
+		int32_t year = yearOfEra + era * 400 + (month <= 1 ? 1 : 0);
+		return DateSpec((uint16_t)year, (uint8_t)month, (uint8_t)day);
 	}
 
 	TASKSCHEDULER_EXPORT bool FormatDateString(wchar_t *dst, size_t dstSize, const DateSpec &date, const TimeSpec &time) 
@@ -5,7 +5,7 @@ namespace task_scheduler {
 	/**
 	 * Allows specification of a specific date
 	 */
-	class TASKSCHEDULER_EXPORT DateSpec
+	class DateSpec
 	{
 		/**
 		 * The four digit year (e.g. 2017)
@@ -30,28 +30,50 @@ namespace task_scheduler {
 		 * @param day The day of the month, starting from 0
 		 * NOTE: Invalid values will default to 0.
 		 */
-		DateSpec(uint16_t year = 0, uint8_t month = 0, uint8_t day = 0);
+		constexpr DateSpec(uint16_t year = 0, uint8_t month = 0, uint8_t day = 0)
+			: year(year), month(month > 11 ? (uint8_t)0 : month), day(day > 30 ? (uint8_t)0 : day)
+		{
+		}
 
 		/**
 		 * Get the year
 		 */
-		uint16_t GetYear() const;
+		constexpr uint16_t GetYear() const
+		{
+			return year;
+		}
 
 		/**
 		 * Get the month
 		 */
-		uint8_t GetMonth() const;
+		constexpr uint8_t GetMonth() const
+		{
+			return month;
+		}
 
 		/**
 		 * Get the day
 		 */
-		uint8_t GetDay() const;
+		constexpr uint8_t GetDay() const
+		{
+			return day;
+		}
+
+		constexpr bool operator==(const DateSpec &rhs) const
+		{
+			return year == rhs.year && month == rhs.month && day == rhs.day;
+		}
+
+		constexpr bool operator!=(const DateSpec &rhs) const
+		{
+			return !(*this == rhs);
+		}
 	};
 
 	/**
 	 * Allows specification of a time of day
 	 */
-	class TASKSCHEDULER_EXPORT TimeSpec
+	class TimeSpec
 	{
 	private:
 		/**
@@ -77,29 +99,164 @@ namespace task_scheduler {
 		 * @param second The second of the minute (0-59)
 		 * NOTE: Invalid values will default to 0
 		 */
-		TimeSpec(uint8_t hour = 0, uint8_t minute = 0, uint8_t second = 0);
+		constexpr TimeSpec(uint8_t hour = 0, uint8_t minute = 0, uint8_t second = 0)
+			: hour(hour > 23 ? (uint8_t)0 : hour), minute(minute > 59 ? (uint8_t)0 : minute),
+			second(second > 59 ? (uint8_t)0 : second)
+		{
+		}
 
 		/**
 		* Get the hour specified
 		*/
-		uint8_t GetHour() const;
+		constexpr uint8_t GetHour() const
+		{
+			return hour;
+		}
 
 		/**
 		* Get the minute specified
 		*/
-		uint8_t GetMinute() const;
+		constexpr uint8_t GetMinute() const
+		{
+			return minute;
+		}
 
 		/**
 		* Get the second specified
 		*/
-		uint8_t GetSecond() const;
+		constexpr uint8_t GetSecond() const
+		{
+			return second;
+		}
+
+		/**
+		 * Get the number of seconds since midnight
+		 */
+		constexpr int32_t GetTotalSeconds() const
+		{
+			return (hour * 3600) + (minute * 60) + second;
+		}
 
 		/**
 		 * Subtract two timespecs to get a duration in seconds.
 		 */
-		int32_t operator-(const TimeSpec &rhs) const;
+		constexpr int32_t operator-(const TimeSpec &rhs) const
+		{
+			return GetTotalSeconds() - rhs.GetTotalSeconds();
+		}
+
+		constexpr bool operator==(const TimeSpec &rhs) const
+		{
+			return hour == rhs.hour && minute == rhs.minute && second == rhs.second;
+		}
+
+		constexpr bool operator!=(const TimeSpec &rhs) const
+		{
+			return !(*this == rhs);
+		}
 	};
 
+	/**
+	 * Test if the given four digit year is a leap year
+	 */
+	constexpr bool IsLeapYear(uint16_t year)
+	{
+		return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+	}
+
+	/**
+	 * Get the number of days in a month
+	 * @param year The four digit year
+	 * @param month The month, starting from 0
+	 */
+	constexpr uint8_t DaysInMonth(uint16_t year, uint8_t month)
+	{
+		return month == 1 ? (IsLeapYear(year) ? 29 : 28) :
+			(month == 3 || month == 5 || month == 8 || month == 10) ? 30 : 31;
+	}
+
+	namespace detail {
+
+		// Helpers for parsing literals in constant expressions.
+		// Each one throws on invalid input, which makes the expression non-constant,
+		// so that a malformed literal used to initialize a constexpr variable fails to compile.
+
+		constexpr int LiteralDigit(const char *str, size_t i)
+		{
+			return (str[i] >= '0' && str[i] <= '9') ? str[i] - '0' :
+				throw std::invalid_argument("Expected a digit");
+		}
+
+		constexpr int LiteralNumber(const char *str, size_t i, size_t digits)
+		{
+			return digits == 0 ? 0 : LiteralNumber(str, i, digits - 1) * 10 + LiteralDigit(str, i + digits - 1);
+		}
+
+		constexpr int LiteralRange(int value, int min, int max)
+		{
+			return (value >= min && value <= max) ? value : throw std::out_of_range("Value out of range");
+		}
+
+		constexpr TimeSpec ParseTimeLiteral(const char *str, size_t len)
+		{
+			return (len != 8 || str[2] != ':' || str[5] != ':') ?
+				throw std::invalid_argument("Expected a time in the format of: HH:MM:SS") :
+				TimeSpec((uint8_t)LiteralRange(LiteralNumber(str, 0, 2), 0, 23),
+					(uint8_t)LiteralRange(LiteralNumber(str, 3, 2), 0, 59),
+					(uint8_t)LiteralRange(LiteralNumber(str, 6, 2), 0, 59));
+		}
+
+		constexpr DateSpec MakeDateLiteral(int year, int month, int day)
+		{
+			return DateSpec((uint16_t)year, (uint8_t)(month - 1),
+				(uint8_t)(LiteralRange(day, 1, DaysInMonth((uint16_t)year, (uint8_t)(month - 1))) - 1));
+		}
+
+		constexpr DateSpec ParseDateLiteral(const char *str, size_t len)
+		{
+			return (len != 10 || str[4] != '/' || str[7] != '/') ?
+				throw std::invalid_argument("Expected a date in the format of: YYYY/MM/DD") :
+				MakeDateLiteral(LiteralRange(LiteralNumber(str, 0, 4), 1970, 9999),
+					LiteralRange(LiteralNumber(str, 5, 2), 1, 12), LiteralNumber(str, 8, 2));
+		}
+
+	}
+
+	namespace literals {
+
+		/**
+		 * A time of day literal in the format of: HH:MM:SS (24-hour clock), e.g. "02:30:00"_time
+		 * Invalid times throw std::invalid_argument or std::out_of_range, and fail to compile
+		 * when used in a constant expression.
+		 */
+		constexpr TimeSpec operator"" _time(const char *str, size_t len)
+		{
+			return detail::ParseTimeLiteral(str, len);
+		}
+
+		/**
+		 * A date literal in the format of: YYYY/MM/DD, e.g. "2024/01/31"_date
+		 * Invalid dates (including days past the end of the month) throw std::invalid_argument
+		 * or std::out_of_range, and fail to compile when used in a constant expression.
+		 */
+		constexpr DateSpec operator"" _date(const char *str, size_t len)
+		{
+			return detail::ParseDateLiteral(str, len);
+		}
+
+	}
+
+	/**
+	 * Convert a date to the number of days since 1970-01-01.
+	 * @param date The date, which must have a non-zero year
+	 */
+	TASKSCHEDULER_EXPORT int32_t DateToDays(const DateSpec &date);
+
+	/**
+	 * Convert a number of days since 1970-01-01 to a date.
+	 */
+	TASKSCHEDULER_EXPORT DateSpec DaysToDate(int32_t days);
+
 	static const size_t DATE_FORMAT_STRING_SIZE = 20;
 	/**
 	 * Format a date (and optional time spec) into the given buffer.
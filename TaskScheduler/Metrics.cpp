@@ -0,0 +1,213 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace task_scheduler {
+
+	// Upper bounds of the histogram buckets in microseconds, the last bucket is unbounded
+	static const uint64_t DURATION_BUCKETS[] = {
+		1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000
+	};
+	static const size_t DURATION_BUCKET_COUNT = sizeof(DURATION_BUCKETS) / sizeof(DURATION_BUCKETS[0]) + 1;
+
+	static const char *COUNTER_NAMES[METRIC_COUNTER_COUNT][2] = {
+		{ "task_scheduler_tasks_registered_total", "Tasks registered with the task service." },
+		{ "task_scheduler_task_registration_errors_total", "Tasks that could not be registered." },
+		{ "task_scheduler_tasks_deleted_total", "Tasks deleted from the task service." },
+		{ "task_scheduler_definitions_built_total", "Task service definitions built rather than reused." },
+		{ "task_scheduler_rate_limited_total", "Calls rejected for being over a rate limit." },
+	};
+
+	static const char *HISTOGRAM_NAMES[METRIC_HISTOGRAM_COUNT][2] = {
+		{ "task_scheduler_connect_duration_seconds", "Time to connect to the task service." },
+		{ "task_scheduler_register_duration_seconds", "Time to register a task with the task service." },
+		{ "task_scheduler_rate_limit_wait_seconds", "Time spent waiting for a rate limit." },
+	};
+
+	// The metrics of a single thread. Only the owning thread writes, so updates are a plain
+	// load and store rather than a locked add, and the padding keeps each thread's counters
+	// on their own cache lines.
+	struct ThreadMetrics
+	{
+		char paddingBefore[64];
+		std::atomic<uint64_t> counters[METRIC_COUNTER_COUNT];
+		std::atomic<uint64_t> buckets[METRIC_HISTOGRAM_COUNT][DURATION_BUCKET_COUNT];
+		std::atomic<uint64_t> sums[METRIC_HISTOGRAM_COUNT];
+		char paddingAfter[64];
+
+		ThreadMetrics()
+		{
+			for (size_t i = 0; i < METRIC_COUNTER_COUNT; i++) {
+				counters[i].store(0, std::memory_order_relaxed);
+			}
+			for (size_t h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+				for (size_t b = 0; b < DURATION_BUCKET_COUNT; b++) {
+					buckets[h][b].store(0, std::memory_order_relaxed);
+				}
+				sums[h].store(0, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	static void Add(std::atomic<uint64_t> &value, uint64_t amount)
+	{
+		value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+
+	// The metrics of every thread that has recorded any. These are kept after the thread
+	// exits, so that its counts are not lost.
+	static std::mutex allThreadsLock;
+	static std::vector<ThreadMetrics *> allThreads;
+
+	static ThreadMetrics &GetThreadMetrics()
+	{
+		static thread_local ThreadMetrics *metrics = NULL;
+		if (!metrics) {
+			metrics = new ThreadMetrics();
+			std::lock_guard<std::mutex> lock(allThreadsLock);
+			allThreads.push_back(metrics);
+		}
+		return *metrics;
+	}
+
+	void AddMetricCounter(MetricCounter counter, uint64_t value)
+	{
+		if (counter < METRIC_COUNTER_COUNT) {
+			Add(GetThreadMetrics().counters[counter], value);
+		}
+	}
+
+	void RecordMetricDuration(MetricHistogram histogram, uint64_t microseconds)
+	{
+		if (histogram >= METRIC_HISTOGRAM_COUNT) {
+			return;
+		}
+
+		size_t bucket = 0;
+		while (bucket < DURATION_BUCKET_COUNT - 1 && microseconds > DURATION_BUCKETS[bucket]) {
+			bucket++;
+		}
+
+		ThreadMetrics &metrics = GetThreadMetrics();
+		Add(metrics.buckets[histogram][bucket], 1);
+		Add(metrics.sums[histogram], microseconds);
+	}
+
+	uint64_t GetMetricCounter(MetricCounter counter)
+	{
+		uint64_t total = 0;
+		if (counter < METRIC_COUNTER_COUNT) {
+			std::lock_guard<std::mutex> lock(allThreadsLock);
+			for (size_t t = 0; t < allThreads.size(); t++) {
+				total += allThreads[t]->counters[counter].load(std::memory_order_relaxed);
+			}
+		}
+		return total;
+	}
+
+	uint64_t GetMetricDurationCount(MetricHistogram histogram)
+	{
+		uint64_t total = 0;
+		if (histogram < METRIC_HISTOGRAM_COUNT) {
+			std::lock_guard<std::mutex> lock(allThreadsLock);
+			for (size_t t = 0; t < allThreads.size(); t++) {
+				for (size_t b = 0; b < DURATION_BUCKET_COUNT; b++) {
+					total += allThreads[t]->buckets[histogram][b].load(std::memory_order_relaxed);
+				}
+			}
+		}
+		return total;
+	}
+
+	void FormatMetrics(std::string &dst)
+	{
+		// Merge the threads' metrics first, so that the lock is not held while formatting
+		uint64_t counters[METRIC_COUNTER_COUNT] = {};
+		uint64_t buckets[METRIC_HISTOGRAM_COUNT][DURATION_BUCKET_COUNT] = {};
+		uint64_t sums[METRIC_HISTOGRAM_COUNT] = {};
+		{
+			std::lock_guard<std::mutex> lock(allThreadsLock);
+			for (size_t t = 0; t < allThreads.size(); t++) {
+				const ThreadMetrics &metrics = *allThreads[t];
+				for (size_t i = 0; i < METRIC_COUNTER_COUNT; i++) {
+					counters[i] += metrics.counters[i].load(std::memory_order_relaxed);
+				}
+				for (size_t h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+					for (size_t b = 0; b < DURATION_BUCKET_COUNT; b++) {
+						buckets[h][b] += metrics.buckets[h][b].load(std::memory_order_relaxed);
+					}
+					sums[h] += metrics.sums[h].load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		char line[256];
+		dst.clear();
+		for (size_t i = 0; i < METRIC_COUNTER_COUNT; i++) {
+			const char *name = COUNTER_NAMES[i][0];
+			sprintf_s(line, sizeof(line), "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+				name, COUNTER_NAMES[i][1], name, name, (unsigned long long)counters[i]);
+			dst += line;
+		}
+
+		for (size_t h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+			const char *name = HISTOGRAM_NAMES[h][0];
+			sprintf_s(line, sizeof(line), "# HELP %s %s\n# TYPE %s histogram\n", name, HISTOGRAM_NAMES[h][1], name);
+			dst += line;
+
+			// Prometheus buckets are cumulative
+			uint64_t count = 0;
+			for (size_t b = 0; b < DURATION_BUCKET_COUNT; b++) {
+				count += buckets[h][b];
+				if (b < DURATION_BUCKET_COUNT - 1) {
+					sprintf_s(line, sizeof(line), "%s_bucket{le=\"%g\"} %llu\n", name,
+						DURATION_BUCKETS[b] / 1e6, (unsigned long long)count);
+				} else {
+					sprintf_s(line, sizeof(line), "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)count);
+				}
+				dst += line;
+			}
+
+			sprintf_s(line, sizeof(line), "%s_sum %.6f\n%s_count %llu\n", name, sums[h] / 1e6, name,
+				(unsigned long long)count);
+			dst += line;
+		}
+	}
+
+	bool WriteMetricsFile(const wchar_t *path)
+	{
+		if (!path || !path[0]) {
+			return false;
+		}
+
+		std::string metrics;
+		FormatMetrics(metrics);
+
+		std::wstring tempPath = std::wstring(path) + L".tmp";
+		HANDLE file = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			fprintf(stderr, "Could not create metrics file %S: %x\n", tempPath.c_str(), GetLastError());
+			return false;
+		}
+
+		DWORD written = 0;
+		BOOL ok = WriteFile(file, metrics.data(), (DWORD)metrics.size(), &written, NULL);
+		CloseHandle(file);
+		if (!ok || written != metrics.size()) {
+			fprintf(stderr, "Could not write metrics file %S: %x\n", tempPath.c_str(), GetLastError());
+			DeleteFileW(tempPath.c_str());
+			return false;
+		}
+
+		if (!MoveFileExW(tempPath.c_str(), path, MOVEFILE_REPLACE_EXISTING)) {
+			fprintf(stderr, "Could not replace metrics file %S: %x\n", path, GetLastError());
+			DeleteFileW(tempPath.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * Counters kept by the library. These only ever increase, from when the library is loaded.
+	 */
+	enum MetricCounter {
+		METRIC_TASKS_REGISTERED,		// Tasks registered with the task service
+		METRIC_TASK_REGISTRATION_ERRORS,// Tasks that could not be registered
+		METRIC_TASKS_DELETED,			// Tasks deleted from the task service
+		METRIC_DEFINITIONS_BUILT,		// Task service definitions built, rather than reused (see RegisterTasks)
+		METRIC_RATE_LIMITED,			// Calls rejected for being over a rate limit (see RateLimiter)
+		METRIC_COUNTER_COUNT
+	};
+
+	/**
+	 * Latency histograms kept by the library
+	 */
+	enum MetricHistogram {
+		METRIC_CONNECT_DURATION,		// Connecting to the task service
+		METRIC_REGISTER_DURATION,		// Registering a single task with the task service
+		METRIC_RATE_LIMIT_WAIT,			// Waiting for a rate limit, by calls that weren't rejected
+		METRIC_HISTOGRAM_COUNT
+	};
+
+	/**
+	 * Add to a counter.
+	 * Each thread has its own set of counters, so this never contends with other threads.
+	 */
+	TASKSCHEDULER_EXPORT void AddMetricCounter(MetricCounter counter, uint64_t value = 1);
+
+	/**
+	 * Record a duration in a histogram, in microseconds
+	 */
+	TASKSCHEDULER_EXPORT void RecordMetricDuration(MetricHistogram histogram, uint64_t microseconds);
+
+	/**
+	 * Get the value of a counter, summed over all threads
+	 */
+	TASKSCHEDULER_EXPORT uint64_t GetMetricCounter(MetricCounter counter);
+
+	/**
+	 * Get the number of durations recorded in a histogram, summed over all threads
+	 */
+	TASKSCHEDULER_EXPORT uint64_t GetMetricDurationCount(MetricHistogram histogram);
+
+	/**
+	 * Format all counters and histograms in the Prometheus text exposition format
+	 * @param dst [out] The string to write the metrics into, existing contents are replaced.
+	 */
+	TASKSCHEDULER_EXPORT void FormatMetrics(std::string &dst);
+
+	/**
+	 * Write all counters and histograms to a file in the Prometheus text exposition format.
+	 * The file is written next to the destination and then moved into place, so a collector
+	 * (such as the node or windows exporter's textfile collector) never reads a partial file.
+	 * @returns true if the file was written
+	 */
+	TASKSCHEDULER_EXPORT bool WriteMetricsFile(const wchar_t *path);
+
+	/**
+	 * Records the time from construction to destruction in a histogram
+	 */
+	class MetricTimer
+	{
+		MetricHistogram histogram;
+		std::chrono::steady_clock::time_point start;
+
+	public:
+		explicit MetricTimer(MetricHistogram histogram)
+			: histogram(histogram), start(std::chrono::steady_clock::now())
+		{
+		}
+
+		~MetricTimer()
+		{
+			RecordMetricDuration(histogram, (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - start).count());
+		}
+
+		MetricTimer(const MetricTimer &) = delete;
+		MetricTimer &operator=(const MetricTimer &) = delete;
+	};
+
+}
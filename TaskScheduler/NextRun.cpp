@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TASKSCHEDULER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace task_scheduler {
+
+	// Split a time into whole days, and seconds since midnight
+	static void SplitTime(int64_t now, int32_t &nowDay, int32_t &nowSeconds)
+	{
+		int64_t day = now / SECONDS_PER_DAY;
+		if (now < 0 && day * SECONDS_PER_DAY != now) {
+			day--;
+		}
+		nowDay = (int32_t)day;
+		nowSeconds = (int32_t)(now - day * SECONDS_PER_DAY);
+	}
+
+	// The next run of a single packed schedule
+	static int64_t NextDailyRun(int32_t startDay, int32_t endDay, int32_t startSeconds,
+		int32_t nowDay, int32_t nowSeconds)
+	{
+		// Run today if the time hasn't passed yet, otherwise tomorrow, but not before the first day
+		int32_t day = startSeconds >= nowSeconds ? nowDay : nowDay + 1;
+		if (startDay > day) {
+			day = startDay;
+		}
+		if (day >= endDay) {
+			return NO_NEXT_RUN;
+		}
+		return (int64_t)day * SECONDS_PER_DAY + startSeconds;
+	}
+
+	TASKSCHEDULER_EXPORT int64_t GetNextDailyRun(const DateSpec &startDate, const DateSpec &endDate,
+		const TimeSpec &dailyStartTime, int64_t now)
+	{
+		int32_t nowDay, nowSeconds;
+		SplitTime(now, nowDay, nowSeconds);
+		return NextDailyRun(startDate.GetYear() ? DateToDays(startDate) : NO_START_DAY,
+			endDate.GetYear() ? DateToDays(endDate) : NO_END_DAY,
+			dailyStartTime.GetTotalSeconds(), nowDay, nowSeconds);
+	}
+
+	TASKSCHEDULER_EXPORT void GetNextDailyRunsScalar(const DailyScheduleColumns &schedules, int64_t now,
+		int64_t *nextRuns)
+	{
+		int32_t nowDay, nowSeconds;
+		SplitTime(now, nowDay, nowSeconds);
+		for (size_t i = 0; i < schedules.count; i++) {
+			nextRuns[i] = NextDailyRun(schedules.startDays[i], schedules.endDays[i], schedules.startSeconds[i],
+				nowDay, nowSeconds);
+		}
+	}
+
+	TASKSCHEDULER_EXPORT void GetNextDailyRuns(const DailyScheduleColumns &schedules, int64_t now, int64_t *nextRuns)
+	{
+#ifdef TASKSCHEDULER_USE_SSE2
+		int32_t nowDay, nowSeconds;
+		SplitTime(now, nowDay, nowSeconds);
+
+		// Days before 1970 would need signed 64-bit multiplication, which SSE2 doesn't have
+		if (nowDay < 0) {
+			GetNextDailyRunsScalar(schedules, now, nextRuns);
+			return;
+		}
+
+		const __m128i vNowDay = _mm_set1_epi32(nowDay);
+		const __m128i vNowSeconds = _mm_set1_epi32(nowSeconds);
+		const __m128i vSecondsPerDay = _mm_set1_epi32(SECONDS_PER_DAY);
+		const __m128i vLowMask = _mm_set_epi32(0, -1, 0, -1);
+
+		size_t i = 0;
+		for (; i + 4 <= schedules.count; i += 4) {
+			__m128i startDay = _mm_loadu_si128((const __m128i *)(schedules.startDays + i));
+			__m128i endDay = _mm_loadu_si128((const __m128i *)(schedules.endDays + i));
+			__m128i startSeconds = _mm_loadu_si128((const __m128i *)(schedules.startSeconds + i));
+
+			// day = nowDay + (startSeconds < nowSeconds ? 1 : 0), the comparison gives -1 for true
+			__m128i day = _mm_sub_epi32(vNowDay, _mm_cmplt_epi32(startSeconds, vNowSeconds));
+
+			// day = max(day, startDay)
+			__m128i later = _mm_cmpgt_epi32(startDay, day);
+			day = _mm_or_si128(_mm_and_si128(later, startDay), _mm_andnot_si128(later, day));
+
+			// Schedules that have ended are all ones, i.e. NO_NEXT_RUN
+			__m128i ended = _mm_xor_si128(_mm_cmpgt_epi32(endDay, day), _mm_set1_epi32(-1));
+
+			// Widen to 64 bits: day * SECONDS_PER_DAY + startSeconds, for lanes 0 and 2, then 1 and 3.
+			// Valid days are never negative, so unsigned multiplication is sufficient.
+			__m128i even = _mm_add_epi64(_mm_mul_epu32(day, vSecondsPerDay), _mm_and_si128(startSeconds, vLowMask));
+			__m128i odd = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(day, 32), vSecondsPerDay),
+				_mm_srli_epi64(startSeconds, 32));
+			even = _mm_or_si128(even, _mm_shuffle_epi32(ended, _MM_SHUFFLE(2, 2, 0, 0)));
+			odd = _mm_or_si128(odd, _mm_shuffle_epi32(ended, _MM_SHUFFLE(3, 3, 1, 1)));
+
+			_mm_storeu_si128((__m128i *)(nextRuns + i), _mm_unpacklo_epi64(even, odd));
+			_mm_storeu_si128((__m128i *)(nextRuns + i + 2), _mm_unpackhi_epi64(even, odd));
+		}
+
+		// Handle the remainder
+		for (; i < schedules.count; i++) {
+			nextRuns[i] = NextDailyRun(schedules.startDays[i], schedules.endDays[i], schedules.startSeconds[i],
+				nowDay, nowSeconds);
+		}
+#else
+		GetNextDailyRunsScalar(schedules, now, nextRuns);
+#endif
+	}
+
+}
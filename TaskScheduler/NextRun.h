@@ -0,0 +1,75 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * Times are expressed as local wall-clock seconds since 1970-01-01T00:00:00, the same
+	 * clock that trigger boundaries are interpreted in, ignoring daylight saving transitions.
+	 */
+	static const int32_t SECONDS_PER_DAY = 86400;
+
+	/**
+	 * Returned when a schedule has no further runs
+	 */
+	static const int64_t NO_NEXT_RUN = -1;
+
+	/**
+	 * Packed start day values for schedules without a start date, and end day values for
+	 * schedules without an end date
+	 */
+	static const int32_t NO_START_DAY = INT32_MIN;
+	static const int32_t NO_END_DAY = INT32_MAX;
+
+	/**
+	 * A set of daily schedules packed into columns, for computing next run times in bulk.
+	 * Each column has count entries.
+	 */
+	struct DailyScheduleColumns
+	{
+		/**
+		 * The first day to run on, as days since 1970-01-01 (see DateToDays), or NO_START_DAY
+		 */
+		const int32_t *startDays;
+
+		/**
+		 * The end date, as days since 1970-01-01, or NO_END_DAY.
+		 * Like the trigger end boundary, the schedule ends at midnight at the start of this day.
+		 */
+		const int32_t *endDays;
+
+		/**
+		 * The time of day to run, as seconds since midnight (see TimeSpec::GetTotalSeconds)
+		 */
+		const int32_t *startSeconds;
+
+		size_t count;
+	};
+
+	/**
+	 * Get the next time a daily schedule runs, at or after the given time.
+	 * @param startDate The starting date, a year of 0 means no starting date
+	 * @param endDate The optional ending date, a year of 0 means no ending date
+	 * @param dailyStartTime The time the schedule runs each day
+	 * @param now The current time, in local seconds since 1970-01-01
+	 * @returns The next run time, or NO_NEXT_RUN if the schedule has ended
+	 */
+	TASKSCHEDULER_EXPORT int64_t GetNextDailyRun(const DateSpec &startDate, const DateSpec &endDate,
+		const TimeSpec &dailyStartTime, int64_t now);
+
+	/**
+	 * Get the next run time of each of a set of daily schedules, at or after the given time.
+	 * This uses SSE2 where available, and otherwise falls back to GetNextDailyRunsScalar.
+	 * @param schedules The packed schedules
+	 * @param now The current time, in local seconds since 1970-01-01
+	 * @param nextRuns [out] The next run time of each schedule, or NO_NEXT_RUN, must have room for
+	 * schedules.count values
+	 */
+	TASKSCHEDULER_EXPORT void GetNextDailyRuns(const DailyScheduleColumns &schedules, int64_t now, int64_t *nextRuns);
+
+	/**
+	 * The portable implementation of GetNextDailyRuns, which gives identical results
+	 */
+	TASKSCHEDULER_EXPORT void GetNextDailyRunsScalar(const DailyScheduleColumns &schedules, int64_t now,
+		int64_t *nextRuns);
+
+}
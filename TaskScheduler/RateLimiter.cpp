@@ -0,0 +1,157 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+#include <cmath>
+#include <cwctype>
+#include <mutex>
+#include <thread>
+
+namespace task_scheduler {
+
+	// The limit and state of one task name prefix.
+	// Rather than counting tokens, the bucket tracks when the last admitted call would have gone ahead
+	// had calls come at the steady rate (the generic cell rate algorithm). This behaves the same, but
+	// only adds and compares whole microseconds, so calls one interval apart are never rejected by rounding.
+	struct RateBucket
+	{
+		std::wstring prefix;
+		int64_t intervalMicroseconds; // Between calls at the steady rate, or 0 for no refill
+		uint32_t burst;
+		int64_t maxWaitMicroseconds;
+		// The time at which the last admitted call would have gone ahead at the steady rate
+		int64_t theoreticalArrival;
+		// The calls left, for buckets that don't refill
+		uint32_t remaining;
+	};
+
+	// Test if a task name starts with a prefix, ignoring case like task names do
+	static bool StartsWith(const wchar_t *taskName, const std::wstring &prefix)
+	{
+		for (size_t i = 0; i < prefix.size(); i++) {
+			if (!taskName[i] || towlower(taskName[i]) != towlower(prefix[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	struct RateLimiter::Impl
+	{
+		std::mutex lock;
+		// Longest prefix first, so the first match is the one that applies
+		std::vector<RateBucket> buckets;
+
+		std::vector<RateBucket>::iterator FindPrefix(const wchar_t *prefix)
+		{
+			return std::find_if(buckets.begin(), buckets.end(), [prefix](const RateBucket &bucket) {
+				return bucket.prefix.size() == wcslen(prefix) && StartsWith(prefix, bucket.prefix);
+			});
+		}
+	};
+
+	RateLimiter::RateLimiter() : impl(new Impl())
+	{
+	}
+
+	RateLimiter::~RateLimiter()
+	{
+		delete impl;
+	}
+
+	void RateLimiter::SetLimit(const wchar_t *prefix, double callsPerSecond, uint32_t burst, uint32_t maxWaitMs)
+	{
+		RateBucket bucket;
+		bucket.prefix = prefix ? prefix : L"";
+		bucket.intervalMicroseconds = callsPerSecond > 0 ? (int64_t)std::ceil(1e6 / callsPerSecond) : 0;
+		bucket.burst = burst ? burst : 1;
+		bucket.maxWaitMicroseconds = (int64_t)maxWaitMs * 1000;
+		bucket.theoreticalArrival = 0;
+		bucket.remaining = bucket.burst;
+
+		std::lock_guard<std::mutex> lock(impl->lock);
+		auto existing = impl->FindPrefix(bucket.prefix.c_str());
+		if (existing != impl->buckets.end()) {
+			*existing = bucket;
+			return;
+		}
+		auto position = std::find_if(impl->buckets.begin(), impl->buckets.end(), [&bucket](const RateBucket &other) {
+			return other.prefix.size() < bucket.prefix.size();
+		});
+		impl->buckets.insert(position, bucket);
+	}
+
+	void RateLimiter::RemoveLimit(const wchar_t *prefix)
+	{
+		std::lock_guard<std::mutex> lock(impl->lock);
+		auto existing = impl->FindPrefix(prefix ? prefix : L"");
+		if (existing != impl->buckets.end()) {
+			impl->buckets.erase(existing);
+		}
+	}
+
+	int64_t RateLimiter::Reserve(const wchar_t *taskName, int64_t nowMicroseconds)
+	{
+		std::lock_guard<std::mutex> lock(impl->lock);
+		auto bucket = std::find_if(impl->buckets.begin(), impl->buckets.end(), [taskName](const RateBucket &bucket) {
+			return StartsWith(taskName ? taskName : L"", bucket.prefix);
+		});
+		if (bucket == impl->buckets.end()) {
+			return 0;
+		}
+
+		if (!bucket->intervalMicroseconds) {
+			if (!bucket->remaining) {
+				return RATE_LIMIT_REJECTED;
+			}
+			bucket->remaining--;
+			return 0;
+		}
+
+		// An idle bucket refills no further than the burst
+		if (bucket->theoreticalArrival < nowMicroseconds) {
+			bucket->theoreticalArrival = nowMicroseconds;
+		}
+
+		// The call can go ahead once there is room for it in the burst, behind any calls already waiting
+		int64_t arrival = bucket->theoreticalArrival + bucket->intervalMicroseconds;
+		int64_t wait = arrival - (int64_t)bucket->burst * bucket->intervalMicroseconds - nowMicroseconds;
+		if (wait > bucket->maxWaitMicroseconds) {
+			return RATE_LIMIT_REJECTED;
+		}
+		bucket->theoreticalArrival = arrival;
+		return wait > 0 ? wait : 0;
+	}
+
+	bool RateLimiter::Acquire(const wchar_t *taskName)
+	{
+		int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		int64_t wait = Reserve(taskName, now);
+		if (wait == RATE_LIMIT_REJECTED) {
+			AddMetricCounter(METRIC_RATE_LIMITED);
+			return false;
+		}
+
+		if (wait > 0) {
+			std::this_thread::sleep_for(std::chrono::microseconds(wait));
+		}
+		RecordMetricDuration(METRIC_RATE_LIMIT_WAIT, (uint64_t)wait);
+		return true;
+	}
+
+	static std::mutex defaultLimiterLock;
+	static std::shared_ptr<RateLimiter> defaultLimiter;
+
+	TASKSCHEDULER_EXPORT void SetDefaultRateLimiter(const std::shared_ptr<RateLimiter> &limiter)
+	{
+		std::lock_guard<std::mutex> lock(defaultLimiterLock);
+		defaultLimiter = limiter;
+	}
+
+	TASKSCHEDULER_EXPORT std::shared_ptr<RateLimiter> GetDefaultRateLimiter()
+	{
+		std::lock_guard<std::mutex> lock(defaultLimiterLock);
+		return defaultLimiter;
+	}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * Returned by RateLimiter::Reserve when a call is over its limit
+	 */
+	static const int64_t RATE_LIMIT_REJECTED = -1;
+
+	/**
+	 * Token bucket limits on how often tasks can be registered or deleted, by task name prefix, so that
+	 * one misbehaving client can't flood the task service. Each prefix has its own bucket, which holds
+	 * up to a burst of calls and refills at a steady rate. A call uses the limit with the longest prefix
+	 * of its task name (ignoring case), and names that match no prefix aren't limited; an empty prefix
+	 * limits every name.
+	 * Calls over the limit either wait for the bucket to refill, if that takes no more than the limit's
+	 * maximum wait, or are rejected straight away, before any work is done.
+	 * A limiter can be shared by any number of sessions and threads.
+	 */
+	class TASKSCHEDULER_EXPORT RateLimiter
+	{
+		struct Impl;
+		Impl *impl;
+
+	public:
+		RateLimiter();
+		~RateLimiter();
+
+		RateLimiter(const RateLimiter &) = delete;
+		RateLimiter &operator=(const RateLimiter &) = delete;
+
+		/**
+		 * Add or replace the limit for a task name prefix. The bucket starts full.
+		 * @param prefix The task name prefix, e.g. L"service-", or L"" for every task
+		 * @param callsPerSecond The rate the bucket refills at, 0 to allow only the burst
+		 * @param burst The most calls allowed at once, at least 1
+		 * @param maxWaitMs How long a call may wait for the bucket to refill before it is rejected
+		 */
+		void SetLimit(const wchar_t *prefix, double callsPerSecond, uint32_t burst, uint32_t maxWaitMs = 0);
+
+		/**
+		 * Remove the limit for a task name prefix, if there is one
+		 */
+		void RemoveLimit(const wchar_t *prefix);
+
+		/**
+		 * Take a call from the bucket of a task name, at the given time. This doesn't wait or record
+		 * metrics, see Acquire.
+		 * @param taskName The task name
+		 * @param nowMicroseconds The current time on a monotonic clock, in microseconds
+		 * @returns How many microseconds the call must wait before going ahead (0 if it can go ahead
+		 * now), or RATE_LIMIT_REJECTED if it is over the limit, in which case nothing is taken
+		 */
+		int64_t Reserve(const wchar_t *taskName, int64_t nowMicroseconds);
+
+		/**
+		 * Take a call from the bucket of a task name, waiting for the bucket to refill if necessary.
+		 * Rejected calls are counted in METRIC_RATE_LIMITED, and the wait of admitted calls is
+		 * recorded in METRIC_RATE_LIMIT_WAIT.
+		 * @returns true if the call can go ahead, false if it is over the limit
+		 */
+		bool Acquire(const wchar_t *taskName);
+	};
+
+	/**
+	 * Set the limiter the free functions in TaskSchedulerAPI.h use, which is checked before they
+	 * connect to the task service. Sessions only use a limiter given to TaskSchedulerSession::SetRateLimiter.
+	 * @param limiter The limiter, or NULL to not limit the free functions (the default)
+	 */
+	TASKSCHEDULER_EXPORT void SetDefaultRateLimiter(const std::shared_ptr<RateLimiter> &limiter);
+
+	/**
+	 * Get the limiter the free functions use, or NULL
+	 */
+	TASKSCHEDULER_EXPORT std::shared_ptr<RateLimiter> GetDefaultRateLimiter();
+
+}
@@ -0,0 +1,141 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+namespace task_scheduler {
+
+	struct RotatingLog::Impl
+	{
+		std::wstring path;
+		HANDLE file;
+		uint64_t size;
+		uint64_t maxBytes;
+		uint32_t maxFiles;
+		uint32_t rotations;
+
+		Impl() : file(INVALID_HANDLE_VALUE), size(0), maxBytes(0), maxFiles(0), rotations(0)
+		{
+		}
+
+		// Open the current file, either appending to it (OPEN_ALWAYS) or emptying it (CREATE_ALWAYS)
+		bool OpenFile(DWORD disposition)
+		{
+			file = CreateFileW(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+				disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (file == INVALID_HANDLE_VALUE) {
+				fprintf(stderr, "Could not open log file %S: %x\n", path.c_str(), GetLastError());
+				return false;
+			}
+
+			LARGE_INTEGER existing;
+			size = GetFileSizeEx(file, &existing) ? (uint64_t)existing.QuadPart : 0;
+			return true;
+		}
+
+		void CloseFile()
+		{
+			if (file != INVALID_HANDLE_VALUE) {
+				CloseHandle(file);
+				file = INVALID_HANDLE_VALUE;
+			}
+		}
+
+		std::wstring GetOldPath(uint32_t index) const
+		{
+			return path + L"." + std::to_wstring(index);
+		}
+
+		// Shift each file along by one, dropping the oldest, and start a new current file
+		// If the current file can't be moved aside, e.g. because another process has it open without
+		// sharing deletes, it is emptied instead, and if that fails too the log can't be written
+		bool Rotate()
+		{
+			CloseFile();
+			bool moved = false;
+			if (maxFiles > 1) {
+				DeleteFileW(GetOldPath(maxFiles - 1).c_str());
+				for (uint32_t i = maxFiles - 1; i > 1; i--) {
+					MoveFileExW(GetOldPath(i - 1).c_str(), GetOldPath(i).c_str(), MOVEFILE_REPLACE_EXISTING);
+				}
+				moved = MoveFileExW(path.c_str(), GetOldPath(1).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+				if (!moved) {
+					fprintf(stderr, "Could not rotate log file %S, emptying it instead: %x\n", path.c_str(),
+						GetLastError());
+				}
+			}
+
+			rotations++;
+			if (!OpenFile(moved ? OPEN_ALWAYS : CREATE_ALWAYS)) {
+				return false;
+			}
+
+			// Another process may have started a new file in the meantime, and writing can't go on if it's full
+			if (size >= maxBytes) {
+				fprintf(stderr, "Log file %S is full after rotating\n", path.c_str());
+				CloseFile();
+				return false;
+			}
+			return true;
+		}
+	};
+
+	RotatingLog::RotatingLog() : impl(new Impl())
+	{
+	}
+
+	RotatingLog::~RotatingLog()
+	{
+		Close();
+		delete impl;
+	}
+
+	bool RotatingLog::Open(const wchar_t *path, uint64_t maxBytes, uint32_t maxFiles)
+	{
+		if (!path || !path[0] || impl->file != INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		impl->path = path;
+		impl->maxBytes = maxBytes ? maxBytes : 1;
+		impl->maxFiles = maxFiles ? maxFiles : 1;
+		impl->rotations = 0;
+		return impl->OpenFile(OPEN_ALWAYS);
+	}
+
+	bool RotatingLog::Write(const void *data, size_t size)
+	{
+		if (impl->file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		const char *bytes = static_cast<const char *>(data);
+		while (size > 0) {
+			if (impl->size >= impl->maxBytes && !impl->Rotate()) {
+				return false;
+			}
+
+			uint64_t room = impl->maxBytes - impl->size;
+			DWORD chunk = (DWORD)std::min<uint64_t>(std::min<uint64_t>(size, room), MAXDWORD);
+			DWORD written = 0;
+			if (!WriteFile(impl->file, bytes, chunk, &written, NULL) || written != chunk) {
+				fprintf(stderr, "Could not write log file %S: %x\n", impl->path.c_str(), GetLastError());
+				return false;
+			}
+
+			impl->size += written;
+			bytes += written;
+			size -= written;
+		}
+		return true;
+	}
+
+	uint32_t RotatingLog::GetRotationCount() const
+	{
+		return impl->rotations;
+	}
+
+	void RotatingLog::Close()
+	{
+		impl->CloseFile();
+	}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * An append-only log file that is capped in size, e.g. for the output of a task. When the file is
+	 * full it is renamed to <path>.1, any existing <path>.1 to <path>.2 and so on, the oldest file is
+	 * deleted, and a new file is started, so the log never takes more than maxBytes * maxFiles.
+	 * Writes go straight to the file, without buffering, so nothing is lost if the writer is stopped.
+	 * The file is shared for reading, so it can be followed while it is written. If it can't be
+	 * renamed, e.g. because a reader has it open without sharing deletes, it is emptied instead.
+	 */
+	class TASKSCHEDULER_EXPORT RotatingLog
+	{
+		struct Impl;
+		Impl *impl;
+
+	public:
+		RotatingLog();
+
+		/**
+		 * Close the file, if it is still open
+		 */
+		~RotatingLog();
+
+		RotatingLog(const RotatingLog &) = delete;
+		RotatingLog &operator=(const RotatingLog &) = delete;
+
+		/**
+		 * Open the log, appending to the existing file if there is one
+		 * @param path The path of the current file
+		 * @param maxBytes The largest each file may grow to, at least 1
+		 * @param maxFiles The number of files to keep, including the current one, at least 1
+		 * @returns true if the file was opened
+		 */
+		bool Open(const wchar_t *path, uint64_t maxBytes, uint32_t maxFiles);
+
+		/**
+		 * Append to the log, rotating as many times as necessary. A write that doesn't fit in the
+		 * current file is split at the cap, so no file is ever larger than maxBytes.
+		 * @returns false if the log could not be written, or could neither be rotated nor emptied, in
+		 * which case the file is closed and later writes fail too
+		 */
+		bool Write(const void *data, size_t size);
+
+		/**
+		 * Get the number of times the log has been rotated since it was opened
+		 */
+		uint32_t GetRotationCount() const;
+
+		/**
+		 * Close the file
+		 */
+		void Close();
+	};
+
+}
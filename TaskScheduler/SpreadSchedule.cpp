@@ -0,0 +1,50 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+#include <cwctype>
+
+namespace task_scheduler {
+
+	uint32_t GetSpreadOffset(const wchar_t *taskName, uint32_t spreadWindow)
+	{
+		if (spreadWindow == 0 || !taskName) {
+			return 0;
+		}
+		if (spreadWindow > MAX_SPREAD_WINDOW) {
+			spreadWindow = MAX_SPREAD_WINDOW;
+		}
+
+		// FNV-1a of the name with its case folded, as the task service ignores case, followed by a
+		// final mix so that names differing only in the last character are not given neighbouring offsets
+		uint32_t hash = 2166136261u;
+		for (const wchar_t *c = taskName; *c; c++) {
+			hash = (hash ^ (uint32_t)towlower(*c)) * 16777619u;
+		}
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6bu;
+		hash ^= hash >> 13;
+
+		// Scale into the window, rather than take the remainder, to avoid favouring low offsets
+		return (uint32_t)(((uint64_t)hash * spreadWindow) >> 32);
+	}
+
+	void SpreadDailyStart(DateSpec &startDate, TimeSpec &dailyStartTime, const wchar_t *taskName,
+		uint32_t spreadWindow)
+	{
+		uint32_t offset = GetSpreadOffset(taskName, spreadWindow);
+		if (offset == 0) {
+			return;
+		}
+
+		uint32_t seconds = (uint32_t)dailyStartTime.GetTotalSeconds() + offset;
+		if (seconds >= (uint32_t)SECONDS_PER_DAY) {
+			seconds -= SECONDS_PER_DAY;
+			if (startDate.GetYear()) {
+				startDate = DaysToDate(DateToDays(startDate) + 1);
+			}
+		}
+
+		dailyStartTime = TimeSpec((uint8_t)(seconds / 3600), (uint8_t)((seconds / 60) % 60), (uint8_t)(seconds % 60));
+	}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * The largest spread window, one day
+	 */
+	static const uint32_t MAX_SPREAD_WINDOW = 86400;
+
+	/**
+	 * Get the offset of a task within a spread window.
+	 * The offset comes from a hash of the task name, so it is the same every time the task is
+	 * registered, and the offsets of many tasks are spread evenly across the window. Names that differ
+	 * only in case, which the task service treats as the same task, have the same offset.
+	 * @param taskName The name of the task
+	 * @param spreadWindow The length of the window in seconds, at most MAX_SPREAD_WINDOW
+	 * @returns The offset in seconds, less than spreadWindow (or 0 if the window is 0)
+	 */
+	TASKSCHEDULER_EXPORT uint32_t GetSpreadOffset(const wchar_t *taskName, uint32_t spreadWindow);
+
+	/**
+	 * Move the start of a daily schedule to the task's offset within a spread window after it.
+	 * If this moves the time past midnight, the start date (if any) moves to the next day, so that
+	 * the first run is still the first run after the original start.
+	 * @param startDate [in, out] The starting date, a year of 0 means no starting date
+	 * @param dailyStartTime [in, out] The time the schedule runs each day
+	 * @param taskName The name of the task
+	 * @param spreadWindow The length of the window in seconds, at most MAX_SPREAD_WINDOW
+	 */
+	TASKSCHEDULER_EXPORT void SpreadDailyStart(DateSpec &startDate, TimeSpec &dailyStartTime, const wchar_t *taskName,
+		uint32_t spreadWindow);
+
+}
@@ -0,0 +1,270 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * Describes a daily executable task, to be registered with TaskSchedulerSession::RegisterTasks.
+	 * This is a value type that is cheap to copy, so that a definition can be built once and
+	 * copied for each of many near-identical tasks:
+	 * - The name, daily start time and dependencies belong to each copy.
+	 * - The arguments are shared between copies until a copy sets its own.
+	 * - The start date, end date, executable, settings, spread window and blackout calendar are shared
+	 *   between copies, and are copied the first time one of the copies modifies them (copy-on-write).
+	 */
+	class TaskDefinition
+	{
+		// The part of the definition that is shared between copies
+		struct Shared
+		{
+			DateSpec startDate;
+			DateSpec endDate;
+			std::wstring exePath;
+			TaskSettings settings;
+			uint32_t spreadWindow;
+			std::shared_ptr<const BlackoutCalendar> blackoutCalendar;
+
+			Shared() : spreadWindow(0)
+			{
+			}
+		};
+
+		std::shared_ptr<Shared> shared;
+		std::shared_ptr<const std::wstring> args;
+		std::wstring name;
+		TimeSpec dailyStartTime;
+		std::vector<std::wstring> dependencies;
+
+		// Get the shared part for modification, copying it first if any other definition refers to it
+		Shared &MutableShared()
+		{
+			if (shared.use_count() != 1) {
+				shared = std::make_shared<Shared>(*shared);
+			}
+			return *shared;
+		}
+
+	public:
+		/**
+		 * The most dependencies a task can be registered with. The task service starts a task when any
+		 * one of its triggers fires, so it can't wait for several tasks to all complete.
+		 */
+		static const size_t MAX_DEPENDENCIES = 1;
+
+		TaskDefinition() : shared(std::make_shared<Shared>())
+		{
+		}
+
+		/**
+		 * Get the task name
+		 */
+		const std::wstring &GetName() const
+		{
+			return name;
+		}
+
+		/**
+		 * Set the name the task will be registered with
+		 */
+		void SetName(const wchar_t *taskName)
+		{
+			name = taskName ? taskName : L"";
+		}
+
+		/**
+		 * Get the starting date
+		 */
+		const DateSpec &GetStartDate() const
+		{
+			return shared->startDate;
+		}
+
+		/**
+		 * Set the starting date
+		 */
+		void SetStartDate(const DateSpec &startDate)
+		{
+			MutableShared().startDate = startDate;
+		}
+
+		/**
+		 * Get the ending date. A year of 0 means the task does not end.
+		 */
+		const DateSpec &GetEndDate() const
+		{
+			return shared->endDate;
+		}
+
+		/**
+		 * Set the optional ending date
+		 */
+		void SetEndDate(const DateSpec &endDate)
+		{
+			MutableShared().endDate = endDate;
+		}
+
+		/**
+		 * Get the time to start the task each day
+		 */
+		const TimeSpec &GetDailyStartTime() const
+		{
+			return dailyStartTime;
+		}
+
+		/**
+		 * Set the time to start the task each day
+		 */
+		void SetDailyStartTime(const TimeSpec &startTime)
+		{
+			dailyStartTime = startTime;
+		}
+
+		/**
+		 * Get the length of the spread window in seconds, 0 if start times are not spread
+		 */
+		uint32_t GetSpreadWindow() const
+		{
+			return shared->spreadWindow;
+		}
+
+		/**
+		 * Spread the start times of tasks that would otherwise all start at the same time.
+		 * Each task then starts at an offset within the window after its daily start time, which
+		 * depends only on its name (see GetSpreadOffset), so re-registering a task doesn't move it.
+		 * @param spreadWindow The length of the window in seconds, at most MAX_SPREAD_WINDOW
+		 */
+		void SetSpreadWindow(uint32_t spreadWindow)
+		{
+			MutableShared().spreadWindow = spreadWindow > MAX_SPREAD_WINDOW ? MAX_SPREAD_WINDOW : spreadWindow;
+		}
+
+		/**
+		 * Get the start date and daily start time the task is actually registered with,
+		 * i.e. after spreading (see SetSpreadWindow)
+		 */
+		void GetSpreadStart(DateSpec &startDate, TimeSpec &dailyStartTime) const
+		{
+			startDate = shared->startDate;
+			dailyStartTime = this->dailyStartTime;
+			SpreadDailyStart(startDate, dailyStartTime, name.c_str(), shared->spreadWindow);
+		}
+
+		/**
+		 * Get the calendar of days the task doesn't run on, or NULL
+		 */
+		const std::shared_ptr<const BlackoutCalendar> &GetBlackoutCalendar() const
+		{
+			return shared->blackoutCalendar;
+		}
+
+		/**
+		 * Skip the days in a calendar, e.g. holidays. The calendar applies to the days the task
+		 * runs on after spreading (see SetSpreadWindow), and is not used by tasks with dependencies.
+		 * The calendar is shared rather than copied, so it can be attached to any number of tasks.
+		 * @param calendar The calendar, or NULL to run every day
+		 */
+		void SetBlackoutCalendar(const std::shared_ptr<const BlackoutCalendar> &calendar)
+		{
+			MutableShared().blackoutCalendar = calendar;
+		}
+
+		/**
+		 * Get the path to the executable
+		 */
+		const std::wstring &GetExecutable() const
+		{
+			return shared->exePath;
+		}
+
+		/**
+		 * Set the path to the executable
+		 */
+		void SetExecutable(const wchar_t *taskExePath)
+		{
+			MutableShared().exePath = taskExePath ? taskExePath : L"";
+		}
+
+		/**
+		 * Get the limits on how the task is run
+		 */
+		const TaskSettings &GetSettings() const
+		{
+			return shared->settings;
+		}
+
+		/**
+		 * Set the limits on how the task is run
+		 */
+		void SetSettings(const TaskSettings &settings)
+		{
+			MutableShared().settings = settings;
+		}
+
+		/**
+		 * Get the arguments, joined into a single string.
+		 */
+		const wchar_t *GetArguments() const
+		{
+			return args ? args->c_str() : L"";
+		}
+
+		/**
+		 * Set the task arguments, which are quoted as necessary (see BuildArgumentString)
+		 * @param taskArgv The task arguments
+		 * @param taskArgc The number of arguments in the argv array
+		 */
+		void SetArguments(const wchar_t **taskArgv, int32_t taskArgc)
+		{
+			std::wstring joined;
+			BuildArgumentString(joined, taskArgv, taskArgc);
+			args = std::make_shared<const std::wstring>(std::move(joined));
+		}
+
+		/**
+		 * Set the task arguments, already joined and quoted into a single string
+		 */
+		void SetArgumentString(const wchar_t *taskArgs)
+		{
+			args = std::make_shared<const std::wstring>(taskArgs ? taskArgs : L"");
+		}
+
+		/**
+		 * Get the names of the tasks this task depends on
+		 */
+		const std::vector<std::wstring> &GetDependencies() const
+		{
+			return dependencies;
+		}
+
+		/**
+		 * Make this task depend on another task, so that instead of running daily it runs each time the
+		 * other task completes successfully. The daily start time is then not used, but the start and
+		 * end dates still limit when the task runs.
+		 * NOTE: More than MAX_DEPENDENCIES can be added, e.g. to order a graph of tasks, but such a task
+		 * is rejected by RegisterTasks.
+		 */
+		void AddDependency(const wchar_t *taskName)
+		{
+			if (taskName && taskName[0]) {
+				dependencies.push_back(taskName);
+			}
+		}
+
+		/**
+		 * Remove all dependencies, so that the task runs daily again
+		 */
+		void ClearDependencies()
+		{
+			dependencies.clear();
+		}
+
+		/**
+		 * Test if this definition shares its start date, end date, executable and settings with another,
+		 * i.e. if they are copies of each other and neither has modified them since.
+		 */
+		bool SharesDefinitionWith(const TaskDefinition &other) const
+		{
+			return shared == other.shared;
+		}
+	};
+
+}
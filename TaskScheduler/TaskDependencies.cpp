@@ -0,0 +1,70 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+#include "TaskSchedulerSupport.h"
+
+#include <unordered_map>
+
+namespace task_scheduler {
+
+	bool SortByDependencies(const TaskDefinition *tasks, size_t count, std::vector<size_t> &order)
+	{
+		order.clear();
+		order.reserve(count);
+
+		std::unordered_map<std::wstring, size_t> indexOfName;
+		indexOfName.reserve(count);
+		std::wstring folded;
+		for (size_t i = 0; i < count; i++) {
+			FoldTaskName(folded, tasks[i].GetName());
+			indexOfName[folded] = i;
+		}
+
+		// Collect the edges, and count the dependents of each task and the prerequisites of each task
+		// within the set
+		std::vector<std::pair<size_t, size_t>> edges;
+		std::vector<size_t> firstDependent(count + 1, 0);
+		std::vector<size_t> waitingOn(count, 0);
+		for (size_t i = 0; i < count; i++) {
+			const std::vector<std::wstring> &dependencies = tasks[i].GetDependencies();
+			for (size_t d = 0; d < dependencies.size(); d++) {
+				FoldTaskName(folded, dependencies[d]);
+				std::unordered_map<std::wstring, size_t>::const_iterator it = indexOfName.find(folded);
+				if (it == indexOfName.end()) {
+					continue;
+				}
+				edges.push_back(std::make_pair(it->second, i));
+				firstDependent[it->second + 1]++;
+				waitingOn[i]++;
+			}
+		}
+
+		// Pack the dependents of each task into one array, so that task i's dependents are
+		// dependents[firstDependent[i]] up to dependents[firstDependent[i + 1]]
+		for (size_t i = 0; i < count; i++) {
+			firstDependent[i + 1] += firstDependent[i];
+		}
+		std::vector<size_t> dependents(edges.size());
+		std::vector<size_t> next(firstDependent.begin(), firstDependent.end() - 1);
+		for (size_t e = 0; e < edges.size(); e++) {
+			dependents[next[edges[e].first]++] = edges[e].second;
+		}
+
+		// Tasks without prerequisites are ready, and order doubles as the queue of ready tasks
+		for (size_t i = 0; i < count; i++) {
+			if (waitingOn[i] == 0) {
+				order.push_back(i);
+			}
+		}
+		for (size_t head = 0; head < order.size(); head++) {
+			size_t task = order[head];
+			for (size_t d = firstDependent[task]; d < firstDependent[task + 1]; d++) {
+				if (--waitingOn[dependents[d]] == 0) {
+					order.push_back(dependents[d]);
+				}
+			}
+		}
+
+		return order.size() == count;
+	}
+
+}
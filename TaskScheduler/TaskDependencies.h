@@ -0,0 +1,19 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * Order a set of task definitions so that every task comes after the tasks it depends on
+	 * (see TaskDefinition::AddDependency), using Kahn's algorithm.
+	 * Dependencies on tasks that are not in the set are assumed to be registered already, and are
+	 * ignored. Names are compared ignoring case, as the task service does. If several definitions have
+	 * the same name, dependencies refer to the last of them, as that is the one that remains registered.
+	 * @param tasks The task definitions
+	 * @param count The number of task definitions
+	 * @param order [out] Indices into tasks, with prerequisites before their dependents. Tasks that are
+	 * part of a dependency cycle, or depend on one, are left out.
+	 * @returns true if there are no dependency cycles, i.e. all count tasks are in order
+	 */
+	TASKSCHEDULER_EXPORT bool SortByDependencies(const TaskDefinition *tasks, size_t count, std::vector<size_t> &order);
+
+}
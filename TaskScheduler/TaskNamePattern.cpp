@@ -0,0 +1,35 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+#include <cwctype>
+
+namespace task_scheduler {
+
+	TASKSCHEDULER_EXPORT bool MatchTaskName(const wchar_t *pattern, const wchar_t *taskName)
+	{
+		// After a mismatch, only the most recent * needs to be retried, matching one more character
+		// each time, so this takes at most length(pattern) * length(name) steps
+		const wchar_t *star = NULL;
+		const wchar_t *starName = NULL;
+		while (*taskName) {
+			if (*pattern == L'*') {
+				star = pattern++;
+				starName = taskName;
+			} else if (*pattern == L'?' || (*pattern && towlower(*pattern) == towlower(*taskName))) {
+				pattern++;
+				taskName++;
+			} else if (star) {
+				pattern = star + 1;
+				taskName = ++starName;
+			} else {
+				return false;
+			}
+		}
+
+		while (*pattern == L'*') {
+			pattern++;
+		}
+		return !*pattern;
+	}
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * Test if a task name matches a pattern, where * matches any run of characters (including none)
+	 * and ? matches any single character. Like task names themselves, matching ignores case.
+	 * A pattern without wildcards only matches the name itself, and a pattern ending in a single *
+	 * matches by prefix, e.g. L"service-*".
+	 * @param pattern The pattern, must be null-terminated
+	 * @param taskName The task name, must be null-terminated
+	 */
+	TASKSCHEDULER_EXPORT bool MatchTaskName(const wchar_t *pattern, const wchar_t *taskName);
+
+}
@@ -4,8 +4,6 @@
 #include "stdafx.h"
 #include <string>
 #include "TaskSchedulerAPI.h"
-
-#include "ComInitialize.h"
 #include "TaskSchedulerSupport.h"
 
 // A few notes about this module:
@@ -17,6 +15,23 @@
 
 namespace task_scheduler {
 
+	// Test if a call on a task is within the default rate limit, before connecting to the task service
+	static bool AdmitDefault(const wchar_t *taskName)
+	{
+		std::shared_ptr<RateLimiter> limiter = GetDefaultRateLimiter();
+		if (limiter && !limiter->Acquire(taskName)) {
+			fprintf(stderr, "Task %S is over its rate limit\n", taskName);
+			return false;
+		}
+		return true;
+	}
+
+	static bool AdmitDefault(const char *taskName)
+	{
+		std::wstring wideName;
+		return !GetDefaultRateLimiter() || !Utf8ToWide(wideName, taskName) || AdmitDefault(wideName.c_str());
+	}
+
 	TASKSCHEDULER_EXPORT ScheduleTaskResult ScheduleDailyExecutableTask(
 		const wchar_t *taskName,
 		const DateSpec &startDate,
@@ -26,104 +41,65 @@ namespace task_scheduler {
 		const wchar_t **taskArgv,
 		int32_t taskArgc)
 	{
-		// Initialize COM & Set security levels
-		// This will automatically uninitialize when we exit the function
-		ComInitialize comInit;
-		if (FAILED(comInit.initResult)) {
-			return SCHEDULE_TASK_ERROR;
+		if (!AdmitDefault(taskName)) {
+			return SCHEDULE_TASK_RATE_LIMITED;
 		}
 
-		// Init service & root folder
-		CComPtr<ITaskService> pTaskSvc;
-		CComPtr<ITaskFolder> pTaskFolder;
-		HRESULT hr = InitTaskServiceAndRootFolder(pTaskSvc, pTaskFolder);
-		if (FAILED(hr)) {
-			return SCHEDULE_TASK_ERROR;
-		}
-
-		// Delete the existing task, if it exists
-		pTaskFolder->DeleteTask(_bstr_t(taskName), 0);
-
-		// Create and configure the task to run daily
-		CComPtr<ITaskDefinition> pTask;
-		hr = CreateDailyTaskWithTrigger(pTaskSvc, pTask, startDate, endDate, dailyStartTime);
-		if (FAILED(hr)) {
-			printf("Could not create a new task: %x\n", hr);
-			return SCHEDULE_TASK_ERROR;
-		}
+		// Initialize COM & connect to the task service
+		// This will automatically uninitialize when we exit the function
+		TaskSchedulerSession session;
+		return session.ScheduleDailyExecutableTask(taskName, startDate, endDate, dailyStartTime,
+			taskExePath, taskArgv, taskArgc);
+	}
 
-		// Once we create the task, the next step is to add an action
-		// We'll add an executable action in this code path
-		hr = CreateExecActionOnTask(pTask, taskExePath, taskArgv, taskArgc);
-		if (FAILED(hr)) {
-			printf("Could not create exec action on task: %x\n", hr);
-			return SCHEDULE_TASK_ERROR;
-		}
-		
-		// Finally, the last step is to register the task
-		// Use current user - otherwise we'd have to supply username, password
-		CComPtr<IRegisteredTask> pRegisteredTask;
-		hr = pTaskFolder->RegisterTaskDefinition(_bstr_t(taskName), pTask, TASK_CREATE_OR_UPDATE,
-			_variant_t(), _variant_t(), TASK_LOGON_INTERACTIVE_TOKEN, _variant_t(L""), &pRegisteredTask);
-
-		if (FAILED(hr)) {
-			printf("Failed to register task: %x\n", hr);
-			return SCHEDULE_TASK_ERROR;
+	TASKSCHEDULER_EXPORT ScheduleTaskResult ScheduleDailyExecutableTask(
+		const char *taskName,
+		const DateSpec &startDate,
+		const DateSpec &endDate,
+		const TimeSpec &dailyStartTime,
+		const char *taskExePath,
+		const char **taskArgv,
+		int32_t taskArgc)
+	{
+		if (!AdmitDefault(taskName)) {
+			return SCHEDULE_TASK_RATE_LIMITED;
 		}
 
-		return SCHEDULE_TASK_OK;
+		TaskSchedulerSession session;
+		return session.ScheduleDailyExecutableTask(taskName, startDate, endDate, dailyStartTime,
+			taskExePath, taskArgv, taskArgc);
 	}
 
 	TASKSCHEDULER_EXPORT bool DeleteTask(const wchar_t *taskName) {
-		// Initialize COM & Set security levels
-		// This will automatically uninitialize when we exit the function
-		ComInitialize comInit;
-		if (FAILED(comInit.initResult)) {
+		if (!AdmitDefault(taskName)) {
 			return false;
 		}
 
-		CComPtr<ITaskService> pTaskSvc;
-		CComPtr<ITaskFolder> pTaskFolder;
-
-		// Init service & root folder
-		HRESULT hr = InitTaskServiceAndRootFolder(pTaskSvc, pTaskFolder);
-		if (FAILED(hr)) {
-			return false;
-		}
+		// Initialize COM & connect to the task service
+		// This will automatically uninitialize when we exit the function
+		TaskSchedulerSession session;
+		return session.DeleteTask(taskName);
+	}
 
-		hr = pTaskFolder->DeleteTask(_bstr_t(taskName), 0);
-		if (FAILED(hr)) {
-			printf("Error deleting task: %x\n", hr);
+	TASKSCHEDULER_EXPORT bool DeleteTask(const char *taskName) {
+		if (!AdmitDefault(taskName)) {
 			return false;
 		}
 
-		return true;
+		TaskSchedulerSession session;
+		return session.DeleteTask(taskName);
 	}
 
 	TASKSCHEDULER_EXPORT bool TaskExists(const wchar_t *taskName) {
-		// Initialize COM & Set security levels
+		// Initialize COM & connect to the task service
 		// This will automatically uninitialize when we exit the function
-		ComInitialize comInit;
-		if (FAILED(comInit.initResult)) {
-			return false;
-		}
-
-		CComPtr<ITaskService> pTaskSvc;
-		CComPtr<ITaskFolder> pTaskFolder;
-
-		// Init service & root folder
-		HRESULT hr = InitTaskServiceAndRootFolder(pTaskSvc, pTaskFolder);
-		if (FAILED(hr)) {
-			return false;
-		}
-
-		CComPtr<IRegisteredTask> pTask;
-		hr = pTaskFolder->GetTask(_bstr_t(taskName), &pTask);
-		if (FAILED(hr)) {
-			return false;
-		}
+		TaskSchedulerSession session;
+		return session.TaskExists(taskName);
+	}
 
-		return !!pTask;
+	TASKSCHEDULER_EXPORT bool TaskExists(const char *taskName) {
+		TaskSchedulerSession session;
+		return session.TaskExists(taskName);
 	}
 
 }
\ No newline at end of file
@@ -2,16 +2,38 @@
 
 #include <atlbase.h>
 #include <atlstr.h>
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "TaskSchedulerExports.h"
 
 #include "DateSpec.h"
+#include "CommandLine.h"
+#include "TaskSettings.h"
+#include "SpreadSchedule.h"
+#include "NextRun.h"
+#include "ClockJump.h"
+#include "BlackoutCalendar.h"
+#include "TaskDefinition.h"
+#include "TaskDependencies.h"
+#include "TaskNamePattern.h"
+#include "TaskTable.h"
+#include "TaskSnapshot.h"
+#include "TaskXml.h"
+#include "Metrics.h"
+#include "Tracing.h"
+#include "RateLimiter.h"
+#include "RotatingLog.h"
 
 namespace task_scheduler {
 	enum ScheduleTaskResult {
 		SCHEDULE_TASK_OK,
-		SCHEDULE_TASK_ERROR // Unspecified error
+		SCHEDULE_TASK_ERROR, // Unspecified error
+		SCHEDULE_TASK_RATE_LIMITED // Over a rate limit (see RateLimiter), nothing was done
 	};
 
 	/**
@@ -20,7 +42,7 @@ namespace task_scheduler {
 	 * @param endDate The optional ending date
 	 * @param dailyStartTime The time to start the task each day
 	 * @param taskExePath The path to the executable
-	 * @param taskArgv Optional task arguments
+	 * @param taskArgv Optional task arguments, which will be quoted as necessary (see BuildArgumentString)
 	 * @param taskArgc The number of arguments in the argv array
 	 * @returns A result code indicating success or failure.
 	 */
@@ -34,6 +56,22 @@ namespace task_scheduler {
 		int32_t taskArgc
 	);
 
+	/**
+	 * Schedules a task to be run once daily at the specified time, as the current user.
+	 * This is the same as above, but takes null-terminated UTF-8 strings, which are converted
+	 * once when passed to the task service.
+	 * @returns A result code indicating success or failure.
+	 */
+	TASKSCHEDULER_EXPORT ScheduleTaskResult ScheduleDailyExecutableTask(
+		const char *taskName,
+		const DateSpec &startDate,
+		const DateSpec &endDate,
+		const TimeSpec &dailyStartTime,
+		const char *taskExePath,
+		const char **taskArgv,
+		int32_t taskArgc
+	);
+
 	/**
 	 * Delete an existing task. If the specified task does not exist, this is a no-op.
 	 * @param taskName The name of the task to delete.
@@ -41,10 +79,21 @@ namespace task_scheduler {
 	 */
 	TASKSCHEDULER_EXPORT bool DeleteTask(const wchar_t *taskName);
 
+	/**
+	 * Delete an existing task, given a UTF-8 task name.
+	 */
+	TASKSCHEDULER_EXPORT bool DeleteTask(const char *taskName);
+
 	/**
 	 * Test if a task exists
 	 */
 	TASKSCHEDULER_EXPORT bool TaskExists(const wchar_t *taskName);
 
+	/**
+	 * Test if a task exists, given a UTF-8 task name.
+	 */
+	TASKSCHEDULER_EXPORT bool TaskExists(const char *taskName);
+
 }
 
+#include "TaskSchedulerSession.h"
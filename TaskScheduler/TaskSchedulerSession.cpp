@@ -0,0 +1,709 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+#include "ComInitialize.h"
+#include "TaskSchedulerSupport.h"
+
+#include <unordered_map>
+
+namespace task_scheduler {
+
+	// The error reported for tasks a bulk operation skipped for being over a rate limit
+	static const HRESULT RATE_LIMITED_ERROR = HRESULT_FROM_WIN32(ERROR_RETRY);
+
+	struct TaskSchedulerSession::Impl
+	{
+		// Declared first, so that COM is uninitialized after the interfaces are released
+		ComInitialize comInit;
+		CComPtr<ITaskService> pTaskSvc;
+		CComPtr<ITaskFolder> pTaskFolder;
+		std::shared_ptr<RateLimiter> rateLimiter;
+		bool connected;
+
+		Impl() : connected(false)
+		{
+			if (FAILED(comInit.initResult)) {
+				return;
+			}
+
+			// Init service & root folder
+			TASKSCHEDULER_TRACE_SPAN("Connect");
+			MetricTimer timer(METRIC_CONNECT_DURATION);
+			HRESULT hr = InitTaskServiceAndRootFolder(pTaskSvc, pTaskFolder);
+			connected = SUCCEEDED(hr);
+		}
+
+		// Register a daily task, with the arguments already joined into a single string
+		ScheduleTaskResult ScheduleDailyExecutableTask(
+			const wchar_t *taskName,
+			const DateSpec &startDate,
+			const DateSpec &endDate,
+			const TimeSpec &dailyStartTime,
+			const wchar_t *taskExePath,
+			const wchar_t *taskArgs)
+		{
+			TASKSCHEDULER_TRACE_SPAN("ScheduleDailyExecutableTask");
+			if (!connected) {
+				return SCHEDULE_TASK_ERROR;
+			}
+
+			// Create and configure the task to run daily
+			CComPtr<ITaskDefinition> pTask;
+			HRESULT hr = CreateDailyTaskWithTrigger(pTaskSvc, pTask, startDate, endDate, dailyStartTime,
+				TaskSettings());
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not create a new task: %x\n", hr);
+				return SCHEDULE_TASK_ERROR;
+			}
+
+			// Once we create the task, the next step is to add an action
+			// We'll add an executable action in this code path
+			hr = CreateExecActionOnTask(pTask, taskExePath, taskArgs);
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not create exec action on task: %x\n", hr);
+				return SCHEDULE_TASK_ERROR;
+			}
+
+			// Finally, the last step is to register the task
+			return RegisterTaskDefinition(_bstr_t(taskName), pTask);
+		}
+
+		// List the tasks in the folder, and optionally the result of the last run of each
+		bool ListTasks(std::vector<std::wstring> &names, std::vector<int32_t> *lastResults)
+		{
+			if (!connected) {
+				return false;
+			}
+
+			CComPtr<IRegisteredTaskCollection> pTasks;
+			HRESULT hr = pTaskFolder->GetTasks(TASK_ENUM_HIDDEN, &pTasks);
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not enumerate tasks: %x\n", hr);
+				return false;
+			}
+
+			LONG count = 0;
+			hr = pTasks->get_Count(&count);
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not get task count: %x\n", hr);
+				return false;
+			}
+
+			names.reserve(names.size() + count);
+			if (lastResults) {
+				lastResults->reserve(lastResults->size() + count);
+			}
+
+			// Collection indices start from 1
+			for (LONG i = 1; i <= count; i++) {
+				CComPtr<IRegisteredTask> pTask;
+				hr = pTasks->get_Item(_variant_t(i), &pTask);
+				if (FAILED(hr)) {
+					fprintf(stderr, "Could not get task %ld: %x\n", i, hr);
+					return false;
+				}
+
+				CComBSTR name;
+				hr = pTask->get_Name(&name);
+				if (FAILED(hr)) {
+					fprintf(stderr, "Could not get task name: %x\n", hr);
+					return false;
+				}
+
+				names.push_back(name ? std::wstring(name, name.Length()) : std::wstring());
+
+				if (lastResults) {
+					LONG lastResult = 0;
+					hr = pTask->get_LastTaskResult(&lastResult);
+					if (FAILED(hr)) {
+						fprintf(stderr, "Could not get last task result: %x\n", hr);
+						return false;
+					}
+					lastResults->push_back((int32_t)lastResult);
+				}
+			}
+
+			return true;
+		}
+
+		// Find the tasks in the folder whose names match a pattern
+		bool FindMatchingTasks(const wchar_t *pattern, std::vector<std::wstring> &names,
+			std::vector<CComPtr<IRegisteredTask>> &matches)
+		{
+			CComPtr<IRegisteredTaskCollection> pTasks;
+			HRESULT hr = pTaskFolder->GetTasks(TASK_ENUM_HIDDEN, &pTasks);
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not enumerate tasks: %x\n", hr);
+				return false;
+			}
+
+			LONG count = 0;
+			hr = pTasks->get_Count(&count);
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not get task count: %x\n", hr);
+				return false;
+			}
+
+			// Collection indices start from 1
+			for (LONG i = 1; i <= count; i++) {
+				CComPtr<IRegisteredTask> pTask;
+				CComBSTR name;
+				hr = pTasks->get_Item(_variant_t(i), &pTask);
+				if (SUCCEEDED(hr)) {
+					hr = pTask->get_Name(&name);
+				}
+				if (FAILED(hr)) {
+					fprintf(stderr, "Could not get task %ld: %x\n", i, hr);
+					return false;
+				}
+
+				if (name && MatchTaskName(pattern, name)) {
+					names.push_back(std::wstring(name, name.Length()));
+					matches.push_back(pTask);
+				}
+			}
+
+			return true;
+		}
+
+		// Map the folded name of each task in the folder, and then each of the given tasks, to its spelling,
+		// with the given tasks taking precedence as they are about to replace the registered ones
+		void GetTaskNameSpellings(const TaskDefinition *tasks, size_t count,
+			std::unordered_map<std::wstring, std::wstring> &spellings)
+		{
+			std::vector<std::wstring> names;
+			ListTasks(names, NULL);
+			std::wstring folded;
+			for (size_t i = 0; i < names.size(); i++) {
+				FoldTaskName(folded, names[i]);
+				spellings[folded] = names[i];
+			}
+			for (size_t i = 0; i < count; i++) {
+				FoldTaskName(folded, tasks[i].GetName());
+				spellings[folded] = tasks[i].GetName();
+			}
+		}
+
+		// Record the outcome of a bulk operation on one task
+		static void AddBulkResult(BulkTaskResult &result, const std::wstring &name, HRESULT hr)
+		{
+			if (SUCCEEDED(hr)) {
+				result.succeeded++;
+			} else {
+				result.failedNames.push_back(name);
+				result.failedErrors.push_back((int32_t)hr);
+			}
+		}
+
+		// Test if a call on a task is within the session's rate limit, waiting for it if necessary
+		bool Admit(const wchar_t *taskName)
+		{
+			if (rateLimiter && !rateLimiter->Acquire(taskName)) {
+				fprintf(stderr, "Task %S is over its rate limit\n", taskName);
+				return false;
+			}
+			return true;
+		}
+
+		// Count the result of scheduling a task
+		static ScheduleTaskResult CountResult(ScheduleTaskResult result)
+		{
+			AddMetricCounter(result == SCHEDULE_TASK_OK ? METRIC_TASKS_REGISTERED : METRIC_TASK_REGISTRATION_ERRORS);
+			return result;
+		}
+
+		// Register a task definition, replacing any existing task with the same name
+		ScheduleTaskResult RegisterTaskDefinition(const _bstr_t &name, const CComPtr<ITaskDefinition> &pTask)
+		{
+			// Delete the existing task, if it exists
+			pTaskFolder->DeleteTask(name, 0);
+
+			// Use current user - otherwise we'd have to supply username, password
+			TASKSCHEDULER_TRACE_SPAN("RegisterTaskDefinition");
+			MetricTimer timer(METRIC_REGISTER_DURATION);
+			CComPtr<IRegisteredTask> pRegisteredTask;
+			HRESULT hr = pTaskFolder->RegisterTaskDefinition(name, pTask, TASK_CREATE_OR_UPDATE,
+				_variant_t(), _variant_t(), TASK_LOGON_INTERACTIVE_TOKEN, _variant_t(L""), &pRegisteredTask);
+
+			if (FAILED(hr)) {
+				fprintf(stderr, "Failed to register task: %x\n", hr);
+				return SCHEDULE_TASK_ERROR;
+			}
+
+			return SCHEDULE_TASK_OK;
+		}
+
+		// Update an existing task with a modified copy of its own definition, keeping the account it runs
+		// as. Unlike RegisterTaskDefinition the task isn't deleted first, so it is left as it was if the
+		// update fails, e.g. for a task that runs with a stored password, which we can't supply.
+		ScheduleTaskResult UpdateTaskDefinition(const _bstr_t &name, const CComPtr<ITaskDefinition> &pTask)
+		{
+			CComPtr<IPrincipal> pPrincipal;
+			TASK_LOGON_TYPE logonType = TASK_LOGON_INTERACTIVE_TOKEN;
+			CComBSTR userId;
+			HRESULT hr = pTask->get_Principal(&pPrincipal);
+			if (SUCCEEDED(hr)) {
+				hr = pPrincipal->get_LogonType(&logonType);
+			}
+			if (SUCCEEDED(hr)) {
+				hr = pPrincipal->get_UserId(&userId);
+			}
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not get principal of task %S: %x\n", (const wchar_t *)name, hr);
+				return SCHEDULE_TASK_ERROR;
+			}
+
+			TASKSCHEDULER_TRACE_SPAN("UpdateTaskDefinition");
+			MetricTimer timer(METRIC_REGISTER_DURATION);
+			CComPtr<IRegisteredTask> pRegisteredTask;
+			hr = pTaskFolder->RegisterTaskDefinition(name, pTask, TASK_CREATE_OR_UPDATE,
+				userId.Length() ? _variant_t(userId.m_str) : _variant_t(), _variant_t(), logonType, _variant_t(L""),
+				&pRegisteredTask);
+			if (FAILED(hr)) {
+				fprintf(stderr, "Failed to update task %S: %x\n", (const wchar_t *)name, hr);
+				return SCHEDULE_TASK_ERROR;
+			}
+
+			return SCHEDULE_TASK_OK;
+		}
+	};
+
+	TaskSchedulerSession::TaskSchedulerSession() : impl(new Impl())
+	{
+	}
+
+	TaskSchedulerSession::~TaskSchedulerSession()
+	{
+		delete impl;
+	}
+
+	bool TaskSchedulerSession::IsConnected() const
+	{
+		return impl->connected;
+	}
+
+	void TaskSchedulerSession::SetRateLimiter(const std::shared_ptr<RateLimiter> &limiter)
+	{
+		impl->rateLimiter = limiter;
+	}
+
+	const std::shared_ptr<RateLimiter> &TaskSchedulerSession::GetRateLimiter() const
+	{
+		return impl->rateLimiter;
+	}
+
+	ScheduleTaskResult TaskSchedulerSession::ScheduleDailyExecutableTask(
+		const wchar_t *taskName,
+		const DateSpec &startDate,
+		const DateSpec &endDate,
+		const TimeSpec &dailyStartTime,
+		const wchar_t *taskExePath,
+		const wchar_t **taskArgv,
+		int32_t taskArgc)
+	{
+		if (!impl->connected) {
+			return Impl::CountResult(SCHEDULE_TASK_ERROR);
+		}
+		if (!impl->Admit(taskName)) {
+			return SCHEDULE_TASK_RATE_LIMITED;
+		}
+
+		std::wstring args;
+		BuildArgumentString(args, taskArgv, taskArgc);
+		return Impl::CountResult(impl->ScheduleDailyExecutableTask(taskName, startDate, endDate, dailyStartTime,
+			taskExePath, args.c_str()));
+	}
+
+	ScheduleTaskResult TaskSchedulerSession::ScheduleDailyExecutableTask(
+		const char *taskName,
+		const DateSpec &startDate,
+		const DateSpec &endDate,
+		const TimeSpec &dailyStartTime,
+		const char *taskExePath,
+		const char **taskArgv,
+		int32_t taskArgc)
+	{
+		// Join the arguments while still in UTF-8, so that each string is converted exactly once
+		std::string args;
+		BuildArgumentString(args, taskArgv, taskArgc);
+
+		std::wstring wideName, wideExePath, wideArgs;
+		if (!Utf8ToWide(wideName, taskName) || !Utf8ToWide(wideExePath, taskExePath) ||
+			!Utf8ToWide(wideArgs, args.c_str())) {
+			fprintf(stderr, "Invalid UTF-8 task name, path or arguments\n");
+			return Impl::CountResult(SCHEDULE_TASK_ERROR);
+		}
+		if (!impl->connected) {
+			return Impl::CountResult(SCHEDULE_TASK_ERROR);
+		}
+		if (!impl->Admit(wideName.c_str())) {
+			return SCHEDULE_TASK_RATE_LIMITED;
+		}
+
+		return Impl::CountResult(impl->ScheduleDailyExecutableTask(wideName.c_str(), startDate, endDate,
+			dailyStartTime, wideExePath.c_str(), wideArgs.c_str()));
+	}
+
+	ScheduleTaskResult TaskSchedulerSession::RegisterTask(const TaskDefinition &task)
+	{
+		ScheduleTaskResult result = SCHEDULE_TASK_ERROR;
+		RegisterTasks(&task, 1, &result);
+		return result;
+	}
+
+	size_t TaskSchedulerSession::RegisterTasks(const TaskDefinition *tasks, size_t count, ScheduleTaskResult *results)
+	{
+		TASKSCHEDULER_TRACE_SPAN("RegisterTasks");
+
+		// The task service definition built for the most recent shared definition, along with
+		// the parts of it that may differ between copies
+		const TaskDefinition *pTemplate = NULL;
+		CComPtr<ITaskDefinition> pTask;
+		CComPtr<IExecAction> pExecAction;
+		CComPtr<IDailyTrigger> pDailyTrigger;
+		std::wstring currentArgs;
+		DateSpec currentStartDate;
+		TimeSpec currentStartTime;
+
+		if (!impl->connected) {
+			if (results) {
+				std::fill(results, results + count, SCHEDULE_TASK_ERROR);
+			}
+			AddMetricCounter(METRIC_TASK_REGISTRATION_ERRORS, count);
+			return 0;
+		}
+
+		// Find any tasks that are part of, or depend on, a dependency cycle, which can't be registered
+		std::vector<bool> inCycle;
+		std::unordered_map<std::wstring, std::wstring> spellings;
+		for (size_t i = 0; i < count; i++) {
+			if (!tasks[i].GetDependencies().empty()) {
+				std::vector<size_t> order;
+				if (!SortByDependencies(tasks, count, order)) {
+					inCycle.assign(count, true);
+					for (size_t j = 0; j < order.size(); j++) {
+						inCycle[order[j]] = false;
+					}
+				}
+				impl->GetTaskNameSpellings(tasks, count, spellings);
+				break;
+			}
+		}
+
+		size_t registered = 0;
+		for (size_t i = 0; i < count; i++) {
+			const TaskDefinition &task = tasks[i];
+			if (!impl->Admit(task.GetName().c_str())) {
+				// Nothing was done, so the definition being reused is still intact
+				if (results) {
+					results[i] = SCHEDULE_TASK_RATE_LIMITED;
+				}
+				continue;
+			}
+
+			ScheduleTaskResult result = SCHEDULE_TASK_ERROR;
+			HRESULT hr = S_OK;
+
+			if (task.GetDependencies().size() > TaskDefinition::MAX_DEPENDENCIES) {
+				fprintf(stderr, "Task %S depends on %u tasks, but can only run after one\n", task.GetName().c_str(),
+					(unsigned)task.GetDependencies().size());
+				hr = E_INVALIDARG;
+			} else if (!inCycle.empty() && inCycle[i]) {
+				fprintf(stderr, "Task %S is part of, or depends on, a dependency cycle\n", task.GetName().c_str());
+				hr = E_INVALIDARG;
+			} else if (!task.GetDependencies().empty()) {
+				// Tasks with dependencies have their own triggers, so are always built from scratch,
+				// and don't serve as a template for the tasks that follow
+				pTemplate = NULL;
+				pTask.Release();
+				pExecAction.Release();
+				pDailyTrigger.Release();
+
+				// Completion triggers match the name exactly, so use the prerequisite's registered spelling
+				std::vector<std::wstring> prerequisites(task.GetDependencies());
+				std::wstring folded;
+				for (size_t d = 0; d < prerequisites.size(); d++) {
+					FoldTaskName(folded, prerequisites[d]);
+					std::unordered_map<std::wstring, std::wstring>::const_iterator it = spellings.find(folded);
+					if (it != spellings.end()) {
+						prerequisites[d] = it->second;
+					}
+				}
+
+				hr = CreateTaskWithCompletionTriggers(impl->pTaskSvc, pTask, task.GetStartDate(), task.GetEndDate(),
+					prerequisites, task.GetSettings());
+				if (SUCCEEDED(hr)) {
+					hr = CreateExecActionOnTask(pTask, task.GetExecutable().c_str(), task.GetArguments());
+				}
+				if (FAILED(hr)) {
+					fprintf(stderr, "Could not create a new task: %x\n", hr);
+				}
+			} else if (task.GetBlackoutCalendar()) {
+				// As are tasks with blackout days, as their triggers depend on the start date
+				pTemplate = NULL;
+				pTask.Release();
+				pExecAction.Release();
+				pDailyTrigger.Release();
+
+				DateSpec startDate;
+				TimeSpec startTime;
+				task.GetSpreadStart(startDate, startTime);
+				hr = CreateDailyTaskWithBlackout(impl->pTaskSvc, pTask, startDate, task.GetEndDate(), startTime,
+					task.GetSettings(), *task.GetBlackoutCalendar());
+				if (SUCCEEDED(hr)) {
+					hr = CreateExecActionOnTask(pTask, task.GetExecutable().c_str(), task.GetArguments());
+				}
+				if (FAILED(hr)) {
+					fprintf(stderr, "Could not create a new task: %x\n", hr);
+				}
+			} else if (pTemplate && task.SharesDefinitionWith(*pTemplate)) {
+				// Only update what differs from the previously registered copy
+				TASKSCHEDULER_TRACE_SPAN("UpdateTaskDefinition");
+				if (currentArgs != task.GetArguments()) {
+					currentArgs = task.GetArguments();
+					hr = pExecAction->put_Arguments(_bstr_t(currentArgs.c_str()));
+					if (FAILED(hr)) {
+						fprintf(stderr, "Could not set executable action arguments: %x\n", hr);
+					}
+				}
+				DateSpec startDate;
+				TimeSpec startTime;
+				task.GetSpreadStart(startDate, startTime);
+				if (SUCCEEDED(hr) && (currentStartDate != startDate || currentStartTime != startTime)) {
+					currentStartDate = startDate;
+					currentStartTime = startTime;
+					hr = SetDailyTriggerStartBoundary(pDailyTrigger, currentStartDate, currentStartTime);
+				}
+			} else {
+				// Build a new task service definition
+				pTemplate = NULL;
+				pTask.Release();
+				pExecAction.Release();
+				pDailyTrigger.Release();
+
+				currentArgs = task.GetArguments();
+				task.GetSpreadStart(currentStartDate, currentStartTime);
+				hr = CreateDailyTaskWithTrigger(impl->pTaskSvc, pTask, currentStartDate, task.GetEndDate(),
+					currentStartTime, task.GetSettings());
+				if (SUCCEEDED(hr)) {
+					hr = CreateExecActionOnTask(pTask, task.GetExecutable().c_str(), currentArgs.c_str());
+				}
+				if (SUCCEEDED(hr)) {
+					hr = GetTaskExecAction(pTask, pExecAction);
+				}
+				if (SUCCEEDED(hr)) {
+					hr = GetTaskDailyTrigger(pTask, pDailyTrigger);
+				}
+
+				if (SUCCEEDED(hr)) {
+					pTemplate = &task;
+				} else {
+					fprintf(stderr, "Could not create a new task: %x\n", hr);
+				}
+			}
+
+			if (SUCCEEDED(hr)) {
+				result = impl->RegisterTaskDefinition(_bstr_t(task.GetName().c_str()), pTask);
+			} else {
+				// Don't reuse a definition that may be partially updated
+				pTemplate = NULL;
+			}
+
+			if (Impl::CountResult(result) == SCHEDULE_TASK_OK) {
+				registered++;
+			}
+			if (results) {
+				results[i] = result;
+			}
+		}
+
+		return registered;
+	}
+
+	bool TaskSchedulerSession::DeleteTask(const wchar_t *taskName)
+	{
+		return DeleteTask(taskName, NULL);
+	}
+
+	bool TaskSchedulerSession::DeleteTask(const wchar_t *taskName, bool *rateLimited)
+	{
+		if (rateLimited) {
+			*rateLimited = false;
+		}
+		if (!impl->connected) {
+			return false;
+		}
+		if (!impl->Admit(taskName)) {
+			if (rateLimited) {
+				*rateLimited = true;
+			}
+			return false;
+		}
+
+		TASKSCHEDULER_TRACE_SPAN("DeleteTask");
+		HRESULT hr = impl->pTaskFolder->DeleteTask(_bstr_t(taskName), 0);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Error deleting task: %x\n", hr);
+			return false;
+		}
+
+		AddMetricCounter(METRIC_TASKS_DELETED);
+		return true;
+	}
+
+	bool TaskSchedulerSession::TaskExists(const wchar_t *taskName)
+	{
+		if (!impl->connected) {
+			return false;
+		}
+
+		CComPtr<IRegisteredTask> pTask;
+		HRESULT hr = impl->pTaskFolder->GetTask(_bstr_t(taskName), &pTask);
+		if (FAILED(hr)) {
+			return false;
+		}
+
+		return !!pTask;
+	}
+
+	bool TaskSchedulerSession::DeleteTask(const char *taskName)
+	{
+		std::wstring wideName;
+		if (!Utf8ToWide(wideName, taskName)) {
+			return false;
+		}
+		return DeleteTask(wideName.c_str());
+	}
+
+	bool TaskSchedulerSession::TaskExists(const char *taskName)
+	{
+		std::wstring wideName;
+		if (!Utf8ToWide(wideName, taskName)) {
+			return false;
+		}
+		return TaskExists(wideName.c_str());
+	}
+
+	bool TaskSchedulerSession::ListTasks(std::vector<std::wstring> &names)
+	{
+		return impl->ListTasks(names, NULL);
+	}
+
+	bool TaskSchedulerSession::ListTasks(std::vector<std::wstring> &names, std::vector<int32_t> &lastResults)
+	{
+		return impl->ListTasks(names, &lastResults);
+	}
+
+	bool TaskSchedulerSession::DeleteTasks(const wchar_t *pattern, BulkTaskResult &result)
+	{
+		result = BulkTaskResult();
+		std::vector<std::wstring> names;
+		std::vector<CComPtr<IRegisteredTask>> matches;
+		if (!impl->connected || !pattern || !impl->FindMatchingTasks(pattern, names, matches)) {
+			return false;
+		}
+
+		TASKSCHEDULER_TRACE_SPAN("DeleteTasks");
+		result.matched = (uint32_t)names.size();
+		for (size_t i = 0; i < names.size(); i++) {
+			if (!impl->Admit(names[i].c_str())) {
+				Impl::AddBulkResult(result, names[i], RATE_LIMITED_ERROR);
+				continue;
+			}
+
+			HRESULT hr = impl->pTaskFolder->DeleteTask(_bstr_t(names[i].c_str()), 0);
+			if (SUCCEEDED(hr)) {
+				AddMetricCounter(METRIC_TASKS_DELETED);
+			}
+			Impl::AddBulkResult(result, names[i], hr);
+		}
+
+		return result.failedNames.empty();
+	}
+
+	bool TaskSchedulerSession::RetimeTasks(const wchar_t *pattern, const TimeSpec &dailyStartTime,
+		BulkTaskResult &result)
+	{
+		result = BulkTaskResult();
+		std::vector<std::wstring> names;
+		std::vector<CComPtr<IRegisteredTask>> matches;
+		if (!impl->connected || !pattern || !impl->FindMatchingTasks(pattern, names, matches)) {
+			return false;
+		}
+
+		TASKSCHEDULER_TRACE_SPAN("RetimeTasks");
+		result.matched = (uint32_t)names.size();
+		for (size_t i = 0; i < names.size(); i++) {
+			if (!impl->Admit(names[i].c_str())) {
+				Impl::AddBulkResult(result, names[i], RATE_LIMITED_ERROR);
+				continue;
+			}
+
+			// Update the task's own definition, so that anything this library doesn't know about is kept
+			CComPtr<ITaskDefinition> pTask;
+			HRESULT hr = matches[i]->get_Definition(&pTask);
+			if (SUCCEEDED(hr)) {
+				hr = SetDailyTriggersStartTime(pTask, dailyStartTime);
+				if (hr == S_FALSE) {
+					fprintf(stderr, "Task %S has no daily trigger\n", names[i].c_str());
+					hr = E_INVALIDARG;
+				}
+			}
+			if (SUCCEEDED(hr) &&
+				Impl::CountResult(impl->UpdateTaskDefinition(_bstr_t(names[i].c_str()), pTask)) != SCHEDULE_TASK_OK) {
+				hr = E_FAIL;
+			}
+			Impl::AddBulkResult(result, names[i], hr);
+		}
+
+		return result.failedNames.empty();
+	}
+
+	bool TaskSchedulerSession::GetTaskXml(const wchar_t *taskName, std::wstring &xml)
+	{
+		if (!impl->connected) {
+			return false;
+		}
+
+		CComPtr<IRegisteredTask> pTask;
+		HRESULT hr = impl->pTaskFolder->GetTask(_bstr_t(taskName), &pTask);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not get task %S: %x\n", taskName, hr);
+			return false;
+		}
+
+		CComBSTR taskXml;
+		hr = pTask->get_Xml(&taskXml);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not get XML of task %S: %x\n", taskName, hr);
+			return false;
+		}
+
+		xml.assign(taskXml ? taskXml.m_str : L"", taskXml.Length());
+		return true;
+	}
+
+	ScheduleTaskResult TaskSchedulerSession::RegisterTaskXml(const wchar_t *taskName, const wchar_t *xml)
+	{
+		if (!impl->connected || !taskName || !xml) {
+			return Impl::CountResult(SCHEDULE_TASK_ERROR);
+		}
+		if (!impl->Admit(taskName)) {
+			return SCHEDULE_TASK_RATE_LIMITED;
+		}
+
+		// Use current user - otherwise we'd have to supply username, password
+		TASKSCHEDULER_TRACE_SPAN("RegisterTaskXml");
+		MetricTimer timer(METRIC_REGISTER_DURATION);
+		CComPtr<IRegisteredTask> pRegisteredTask;
+		HRESULT hr = impl->pTaskFolder->RegisterTask(_bstr_t(taskName), _bstr_t(xml), TASK_CREATE_OR_UPDATE,
+			_variant_t(), _variant_t(), TASK_LOGON_INTERACTIVE_TOKEN, _variant_t(L""), &pRegisteredTask);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Failed to register task %S from XML: %x\n", taskName, hr);
+			return Impl::CountResult(SCHEDULE_TASK_ERROR);
+		}
+
+		return Impl::CountResult(SCHEDULE_TASK_OK);
+	}
+
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * The outcome of an operation on all tasks matching a pattern, see TaskSchedulerSession::DeleteTasks
+	 */
+	struct BulkTaskResult
+	{
+		uint32_t matched; // The number of tasks whose names matched
+		uint32_t succeeded; // The number of those the operation succeeded on
+		std::vector<std::wstring> failedNames; // The name of each task the operation failed on
+		std::vector<int32_t> failedErrors; // The HRESULT of each failure, in the same order
+
+		BulkTaskResult() : matched(0), succeeded(0)
+		{
+		}
+	};
+
+	/**
+	 * Holds an initialized connection to the task scheduler service, so that
+	 * several operations can share the cost of COM initialization and connecting
+	 * to the service. The free functions in TaskSchedulerAPI.h create a temporary
+	 * session for each call.
+	 * NOTE: A session initializes COM for the thread that creates it, and should
+	 * only be used from that thread.
+	 */
+	class TASKSCHEDULER_EXPORT TaskSchedulerSession
+	{
+		struct Impl;
+		Impl *impl;
+
+	public:
+		/**
+		 * Initialize COM and connect to the task service.
+		 * Use IsConnected() to check whether this succeeded.
+		 */
+		TaskSchedulerSession();
+		~TaskSchedulerSession();
+
+		TaskSchedulerSession(const TaskSchedulerSession &) = delete;
+		TaskSchedulerSession &operator=(const TaskSchedulerSession &) = delete;
+
+		/**
+		 * Test if the session was able to connect to the task service
+		 */
+		bool IsConnected() const;
+
+		/**
+		 * Limit how often this session registers and deletes tasks. Calls over the limit fail with
+		 * SCHEDULE_TASK_RATE_LIMITED (or false), before anything is sent to the task service.
+		 * A limiter can be shared between sessions, so that they are limited together.
+		 * @param limiter The limiter, or NULL to not limit this session (the default)
+		 */
+		void SetRateLimiter(const std::shared_ptr<RateLimiter> &limiter);
+
+		/**
+		 * Get the limiter of this session, or NULL
+		 */
+		const std::shared_ptr<RateLimiter> &GetRateLimiter() const;
+
+		/**
+		 * Schedules a task to be run once daily at the specified time, as the current user.
+		 * See task_scheduler::ScheduleDailyExecutableTask for a description of the parameters.
+		 */
+		ScheduleTaskResult ScheduleDailyExecutableTask(
+			const wchar_t *taskName,
+			const DateSpec &startDate,
+			const DateSpec &endDate,
+			const TimeSpec &dailyStartTime,
+			const wchar_t *taskExePath,
+			const wchar_t **taskArgv,
+			int32_t taskArgc
+		);
+
+		/**
+		 * Schedules a task to be run once daily, taking UTF-8 strings.
+		 * See task_scheduler::ScheduleDailyExecutableTask for a description of the parameters.
+		 */
+		ScheduleTaskResult ScheduleDailyExecutableTask(
+			const char *taskName,
+			const DateSpec &startDate,
+			const DateSpec &endDate,
+			const TimeSpec &dailyStartTime,
+			const char *taskExePath,
+			const char **taskArgv,
+			int32_t taskArgc
+		);
+
+		/**
+		 * Register a task definition, replacing any existing task with the same name.
+		 * @returns A result code indicating success or failure.
+		 */
+		ScheduleTaskResult RegisterTask(const TaskDefinition &task);
+
+		/**
+		 * Register a number of task definitions, replacing any existing tasks with the same names.
+		 * Consecutive definitions that are copies of each other (see TaskDefinition::SharesDefinitionWith)
+		 * reuse the same task service definition, and only update the arguments and start time for each.
+		 * Tasks that are part of, or depend on, a cycle of dependencies (see TaskDefinition::AddDependency)
+		 * within the array are not registered, nor are tasks with more than TaskDefinition::MAX_DEPENDENCIES.
+		 * Dependencies are matched ignoring case, against the array and then the tasks already in the folder,
+		 * and the prerequisite's own spelling is used for the completion trigger.
+		 * @param tasks The array of task definitions
+		 * @param count The number of task definitions in the array
+		 * @param results [out] Optional array of count results, one for each task definition
+		 * @returns The number of tasks that were registered successfully
+		 */
+		size_t RegisterTasks(const TaskDefinition *tasks, size_t count, ScheduleTaskResult *results = NULL);
+
+		/**
+		 * Delete an existing task.
+		 * @param taskName The name of the task to delete.
+		 * @returns true if the operation succeeded, false otherwise
+		 */
+		bool DeleteTask(const wchar_t *taskName);
+
+		/**
+		 * Delete an existing task, telling a failure due to the session's rate limit apart from others.
+		 * @param rateLimited [out] Optional, set to true if the task wasn't deleted as it was over a rate limit
+		 */
+		bool DeleteTask(const wchar_t *taskName, bool *rateLimited);
+
+		/**
+		 * Delete an existing task, given a UTF-8 task name.
+		 */
+		bool DeleteTask(const char *taskName);
+
+		/**
+		 * Test if a task exists
+		 */
+		bool TaskExists(const wchar_t *taskName);
+
+		/**
+		 * Test if a task exists, given a UTF-8 task name.
+		 */
+		bool TaskExists(const char *taskName);
+
+		/**
+		 * List the names of the tasks in the task folder, including hidden tasks.
+		 * @param names [out] The vector to append task names to
+		 * @returns true if the operation succeeded, false otherwise
+		 */
+		bool ListTasks(std::vector<std::wstring> &names);
+
+		/**
+		 * List the names of the tasks in the task folder along with the result of the last run of each,
+		 * in a single enumeration of the folder.
+		 * @param names [out] The vector to append task names to
+		 * @param lastResults [out] The vector to append the last result of each task to, i.e. the exit code
+		 * of the executable, or SCHED_S_TASK_HAS_NOT_RUN
+		 * @returns true if the operation succeeded, false otherwise
+		 */
+		bool ListTasks(std::vector<std::wstring> &names, std::vector<int32_t> &lastResults);
+
+		/**
+		 * Delete every task in the task folder whose name matches a pattern, e.g. to retire a service.
+		 * @param pattern The pattern, see MatchTaskName, e.g. L"service-*" to delete by prefix
+		 * @param result [out] The number of tasks matched and deleted, and the details of each failure
+		 * @returns true if every matching task was deleted, including if there were none
+		 */
+		bool DeleteTasks(const wchar_t *pattern, BulkTaskResult &result);
+
+		/**
+		 * Change the daily start time of every task in the task folder whose name matches a pattern,
+		 * keeping each task's start date and everything else about it, including the account it runs as.
+		 * Tasks are updated in place, so a task that can't be updated (e.g. one that runs with a stored
+		 * password) is left as it was. Tasks without a daily trigger, e.g. tasks that run after other
+		 * tasks, count as failures.
+		 * @param pattern The pattern, see MatchTaskName
+		 * @param dailyStartTime The new time to run each day
+		 * @param result [out] The number of tasks matched and updated, and the details of each failure
+		 * @returns true if every matching task was updated, including if there were none
+		 */
+		bool RetimeTasks(const wchar_t *pattern, const TimeSpec &dailyStartTime, BulkTaskResult &result);
+
+		/**
+		 * Get the XML of a registered task, as the task service stores it, e.g. to export it
+		 * (see TaskXmlWriter::WriteXml). This keeps everything about the task, including what this
+		 * library doesn't set, such as several actions or triggers of other types.
+		 * @param taskName The name of the task
+		 * @param xml [out] The XML of the task
+		 * @returns true if the operation succeeded, false otherwise
+		 */
+		bool GetTaskXml(const wchar_t *taskName, std::wstring &xml);
+
+		/**
+		 * Register a task from its XML, e.g. as exported by GetTaskXml, replacing any existing task
+		 * with the same name. The task runs as the current user, whatever principal the XML names.
+		 * @param taskName The name to register the task as
+		 * @param xml The XML of the task
+		 * @returns A result code indicating success or failure.
+		 */
+		ScheduleTaskResult RegisterTaskXml(const wchar_t *taskName, const wchar_t *xml);
+	};
+
+}
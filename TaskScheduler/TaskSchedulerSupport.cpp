@@ -2,6 +2,8 @@
 #include "TaskSchedulerAPI.h"
 #include "TaskSchedulerSupport.h"
 
+#include <cwctype>
+
 namespace task_scheduler {
 
 	static const wchar_t * DEFAULT_TASK_FOLDER = L"\\";
@@ -11,65 +13,153 @@ namespace task_scheduler {
 		// Create an instance of the tasks scheduler, and connect
 		HRESULT hr = pTaskSvc.CoCreateInstance(CLSID_TaskScheduler, NULL, CLSCTX_INPROC_SERVER);
 		if (FAILED(hr)) {
-			printf("Unable to initialize task scheduler: %xn", hr);
+			fprintf(stderr, "Unable to initialize task scheduler: %x\n", hr);
 			return hr;
 		}
 
 		// Connect locally
 		hr = pTaskSvc->Connect(_variant_t(), _variant_t(), _variant_t(), _variant_t());
 		if ((FAILED(hr))) {
-			printf("Unable to connect task scheduler: %xn", hr);
+			fprintf(stderr, "Unable to connect task scheduler: %x\n", hr);
 			return hr;
 		}
 
 		// Get the folder that we want to schedule the task under:
 		hr = pTaskSvc->GetFolder(_bstr_t(DEFAULT_TASK_FOLDER), &pTaskFolder);
 		if (FAILED(hr)) {
-			printf("Unable to open the default task folder <%S>: %x\n", DEFAULT_TASK_FOLDER, hr);
+			fprintf(stderr, "Unable to open the default task folder <%S>: %x\n", DEFAULT_TASK_FOLDER, hr);
 			return hr;
 		}
 
 		return S_OK;
 	}
 
-	HRESULT CreateDailyTaskWithTrigger(const CComPtr<ITaskService> &pTaskSvc, CComPtr<ITaskDefinition> &pTask,
-		const DateSpec &startDate, const DateSpec &endDate, const TimeSpec &dailyStartTime)
+	// Create a task without triggers or actions
+	static HRESULT CreateTaskWithSettings(const CComPtr<ITaskService> &pTaskSvc, CComPtr<ITaskDefinition> &pTask,
+		const TaskSettings &settings)
 	{
-		// Create and configure the task
 		HRESULT hr = pTaskSvc->NewTask(0, &pTask);
 		if (FAILED(hr)) {
-			printf("Could not create a new task instance: %x\n", hr);
+			fprintf(stderr, "Could not create a new task instance: %x\n", hr);
 			return hr;
 		}
+		AddMetricCounter(METRIC_DEFINITIONS_BUILT);
 
 		hr = SetTaskLogonType(pTask, TASK_LOGON_INTERACTIVE_TOKEN);
 		if (FAILED(hr)) {
-			printf("Could not set task logon type: %x\n", hr);
+			fprintf(stderr, "Could not set task logon type: %x\n", hr);
+			return hr;
+		}
+
+		hr = SetTaskSettings(pTask, settings);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not update task settings: %x\n", hr);
 			return hr;
 		}
 
-		hr = SetTaskSettings(pTask, true);
+		return S_OK;
+	}
+
+	HRESULT CreateDailyTaskWithTrigger(const CComPtr<ITaskService> &pTaskSvc, CComPtr<ITaskDefinition> &pTask,
+		const DateSpec &startDate, const DateSpec &endDate, const TimeSpec &dailyStartTime,
+		const TaskSettings &settings)
+	{
+		TASKSCHEDULER_TRACE_SPAN("CreateDailyTaskWithTrigger");
+
+		// Create and configure the task
+		HRESULT hr = CreateTaskWithSettings(pTaskSvc, pTask, settings);
 		if (FAILED(hr)) {
-			printf("Could not update task settings: %x\n", hr);
 			return hr;
 		}
 
 		hr = SetTaskDailyTrigger(pTask, startDate, endDate, dailyStartTime);
 		if (FAILED(hr)) {
-			printf("Could not create task trigger: %x\n", hr);
+			fprintf(stderr, "Could not create task trigger: %x\n", hr);
+			return hr;
+		}
+
+		return S_OK;
+	}
+
+	HRESULT CreateDailyTaskWithBlackout(const CComPtr<ITaskService> &pTaskSvc, CComPtr<ITaskDefinition> &pTask,
+		const DateSpec &startDate, const DateSpec &endDate, const TimeSpec &dailyStartTime,
+		const TaskSettings &settings, const BlackoutCalendar &calendar)
+	{
+		// The most triggers the task service allows on one task
+		static const uint32_t MAX_TRIGGERS = 48;
+
+		TASKSCHEDULER_TRACE_SPAN("CreateDailyTaskWithBlackout");
+		HRESULT hr = CreateTaskWithSettings(pTaskSvc, pTask, settings);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		// Blackouts that have already passed don't need triggers
+		SYSTEMTIME now;
+		GetLocalTime(&now);
+		int32_t day = DateToDays(DateSpec(now.wYear, (uint8_t)(now.wMonth - 1), (uint8_t)(now.wDay - 1)));
+		if (startDate.GetYear() && DateToDays(startDate) > day) {
+			day = DateToDays(startDate);
+		}
+		int32_t endDay = endDate.GetYear() ? DateToDays(endDate) : NO_END_DAY;
+
+		// Each trigger ends at midnight at the start of the next blacked out day
+		for (uint32_t triggers = 0; ; triggers++) {
+			day = calendar.GetNextAllowedDay(day);
+			if (day >= endDay) {
+				break;
+			}
+			if (triggers == MAX_TRIGGERS) {
+				fprintf(stderr, "Too many blackout periods, at most %u runs of days between them can be scheduled\n",
+					MAX_TRIGGERS);
+				return E_INVALIDARG;
+			}
+
+			int32_t blackoutDay = calendar.GetNextBlackedOutDay(day, endDay);
+			hr = SetTaskDailyTrigger(pTask, DaysToDate(day),
+				blackoutDay == NO_END_DAY ? DateSpec() : DaysToDate(blackoutDay), dailyStartTime, triggers + 1);
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not create task trigger: %x\n", hr);
+				return hr;
+			}
+			if (blackoutDay >= endDay) {
+				break;
+			}
+			day = blackoutDay;
+		}
+
+		return S_OK;
+	}
+
+	HRESULT CreateTaskWithCompletionTriggers(const CComPtr<ITaskService> &pTaskSvc, CComPtr<ITaskDefinition> &pTask,
+		const DateSpec &startDate, const DateSpec &endDate, const std::vector<std::wstring> &prerequisites,
+		const TaskSettings &settings)
+	{
+		TASKSCHEDULER_TRACE_SPAN("CreateTaskWithCompletionTriggers");
+		HRESULT hr = CreateTaskWithSettings(pTaskSvc, pTask, settings);
+		if (FAILED(hr)) {
 			return hr;
 		}
 
+		for (size_t i = 0; i < prerequisites.size(); i++) {
+			hr = AddTaskCompletionTrigger(pTask, prerequisites[i], startDate, endDate);
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not create completion trigger on %S: %x\n", prerequisites[i].c_str(), hr);
+				return hr;
+			}
+		}
+
 		return S_OK;
 	}
 
 	HRESULT CreateExecActionOnTask(const CComPtr<ITaskDefinition> &pTask, const wchar_t *taskExePath,
-		const wchar_t **taskArgv, int32_t taskArgc)
+		const wchar_t *taskArgs)
 	{
+		TASKSCHEDULER_TRACE_SPAN("CreateExecActionOnTask");
 		CComPtr<IActionCollection> pActions;
 		HRESULT hr = pTask->get_Actions(&pActions);
 		if (FAILED(hr)) {
-			printf("Could not get action collection for task: %x\n", hr);
+			fprintf(stderr, "Could not get action collection for task: %x\n", hr);
 			return hr;
 		}
 
@@ -77,7 +167,7 @@ namespace task_scheduler {
 		CComPtr<IAction> pAction;
 		hr = pActions->Create(TASK_ACTION_EXEC, &pAction);
 		if (FAILED(hr)) {
-			printf("Could not create an executable action for task: %x\n", hr);
+			fprintf(stderr, "Could not create an executable action for task: %x\n", hr);
 			return hr;
 		}
 
@@ -85,7 +175,7 @@ namespace task_scheduler {
 		CComPtr<IExecAction> pExeAction;
 		hr = pAction.QueryInterface(&pExeAction);
 		if (FAILED(hr)) {
-			printf("Could not query for executable action: %x\n", hr);
+			fprintf(stderr, "Could not query for executable action: %x\n", hr);
 			return hr;
 		}
 		pAction.Release();
@@ -93,26 +183,14 @@ namespace task_scheduler {
 		// TODO: Do we need to take a working directory here?
 		hr = pExeAction->put_Path(_bstr_t(taskExePath));
 		if (FAILED(hr)) {
-			printf("Could not set executable action path: %x\n", hr);
+			fprintf(stderr, "Could not set executable action path: %x\n", hr);
 			return hr;
 		}
 
-		if (taskArgv && taskArgc) {
-			std::wstring args;
-			// Known limitiation - we do not support arguments with spaces, it's up to the caller
-			// To wrap their arguments in quotes and escape any necessary values
-			for (int32_t i = 0; i < taskArgc; i++) {
-				if (taskArgv[i] && taskArgv[i][0]) {
-					if (!args.empty()) {
-						args.push_back(L' ');
-					}
-					args.append(taskArgv[i]);
-				}
-			}
-
-			hr = pExeAction->put_Arguments(_bstr_t(args.c_str()));
+		if (taskArgs && taskArgs[0]) {
+			hr = pExeAction->put_Arguments(_bstr_t(taskArgs));
 			if (FAILED(hr)) {
-				printf("Could not set executable action arguments: %x\n", hr);
+				fprintf(stderr, "Could not set executable action arguments: %x\n", hr);
 				return hr;
 			}
 		}
@@ -120,6 +198,13 @@ namespace task_scheduler {
 		return S_OK;
 	}
 
+	HRESULT CreateExecActionOnTask(const CComPtr<ITaskDefinition> &pTask, const wchar_t *taskExePath,
+		const wchar_t **taskArgv, int32_t taskArgc)
+	{
+		std::wstring args;
+		BuildArgumentString(args, taskArgv, taskArgc);
+		return CreateExecActionOnTask(pTask, taskExePath, args.c_str());
+	}
 
 	HRESULT SetTaskLogonType(const CComPtr<ITaskDefinition> &pTask, TASK_LOGON_TYPE logonType)
 	{
@@ -132,25 +217,68 @@ namespace task_scheduler {
 		return pPrincipal->put_LogonType(logonType);
 	}
 
-	HRESULT SetTaskSettings(const CComPtr<ITaskDefinition> &pTask, bool startWhenAvailable)
+	HRESULT SetTaskSettings(const CComPtr<ITaskDefinition> &pTask, const TaskSettings &settings)
 	{
-		// Default
-		if (!startWhenAvailable) {
-			return S_OK;
-		}
-
-		// TODO: Add more setting options, such as idle time, etc.
 		CComPtr<ITaskSettings> pSettings;
 		HRESULT hr = pTask->get_Settings(&pSettings);
 		if (FAILED(hr)) {
 			return hr;
 		}
 
-		return pSettings->put_StartWhenAvailable(VARIANT_TRUE);
+		hr = pSettings->put_StartWhenAvailable(settings.startWhenAvailable ? VARIANT_TRUE : VARIANT_FALSE);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		if (settings.executionTimeLimit >= 0) {
+			// A limit of zero lets the task run indefinitely
+			std::wstring limit;
+			FormatDuration(limit, static_cast<uint32_t>(settings.executionTimeLimit));
+			hr = pSettings->put_ExecutionTimeLimit(_bstr_t(limit.c_str()));
+			if (FAILED(hr)) {
+				return hr;
+			}
+		}
+
+		if (settings.priority >= 0) {
+			hr = pSettings->put_Priority(settings.priority);
+			if (FAILED(hr)) {
+				return hr;
+			}
+		}
+
+		TASK_INSTANCES_POLICY policy;
+		switch (settings.instancesPolicy) {
+		case INSTANCES_QUEUE:
+			policy = TASK_INSTANCES_QUEUE;
+			break;
+		case INSTANCES_STOP_EXISTING:
+			policy = TASK_INSTANCES_STOP_EXISTING;
+			break;
+		case INSTANCES_PARALLEL:
+			policy = TASK_INSTANCES_PARALLEL;
+			break;
+		default:
+			policy = TASK_INSTANCES_IGNORE_NEW;
+			break;
+		}
+		return pSettings->put_MultipleInstances(policy);
+	}
+
+	void FormatDuration(std::wstring &dst, uint32_t seconds)
+	{
+		uint32_t days = seconds / (24 * 60 * 60);
+		uint32_t hours = (seconds / (60 * 60)) % 24;
+		uint32_t minutes = (seconds / 60) % 60;
+		seconds %= 60;
+
+		wchar_t buffer[64];
+		int length = _snwprintf_s(buffer, _countof(buffer), _TRUNCATE, L"P%uDT%uH%uM%uS", days, hours, minutes, seconds);
+		dst.assign(buffer, length > 0 ? length : 0);
 	}
 
 	HRESULT SetTaskDailyTrigger(const CComPtr<ITaskDefinition> &pTask, const DateSpec &startDate,
-		const DateSpec &endDate, const TimeSpec &dailyStartTime)
+		const DateSpec &endDate, const TimeSpec &dailyStartTime, uint32_t number)
 	{
 		CComPtr<ITriggerCollection> pTriggerCollection;
 		CComPtr<ITrigger> pTrigger;
@@ -159,34 +287,36 @@ namespace task_scheduler {
 
 		HRESULT hr = pTask->get_Triggers(&pTriggerCollection);
 		if (FAILED(hr)) {
-			printf("Could not get trigger collection: %x\n", hr);
+			fprintf(stderr, "Could not get trigger collection: %x\n", hr);
 			return hr;
 		}
 
 		hr = pTriggerCollection->Create(TASK_TRIGGER_DAILY, &pTrigger);
 		if (FAILED(hr)) {
-			printf("Could not create daily trigger: %x\n", hr);
+			fprintf(stderr, "Could not create daily trigger: %x\n", hr);
 			return hr;
 		}
 
 		hr = pTrigger.QueryInterface(&pDailyTrigger);
 		if (FAILED(hr)) {
-			printf("Could not query daily trigger interface: %x\n", hr);
+			fprintf(stderr, "Could not query daily trigger interface: %x\n", hr);
 			return hr;
 		}
 		pTrigger.Release();
 
-		// Set trigger id
-		hr = pDailyTrigger->put_Id(_bstr_t("Daily Trigger"));
+		// Set trigger id, numbered if the task has several
+		std::wstring id(L"Daily Trigger");
+		if (number) {
+			id += L" " + std::to_wstring(number);
+		}
+		hr = pDailyTrigger->put_Id(_bstr_t(id.c_str()));
 		if (FAILED(hr)) {
-			printf("Could not set trigger id: %x\n", hr);
+			fprintf(stderr, "Could not set trigger id: %x\n", hr);
 		}
 
 		// Set start time
-		FormatDateString(timespec, DATE_FORMAT_STRING_SIZE, startDate, dailyStartTime);
-		hr = pDailyTrigger->put_StartBoundary(_bstr_t(timespec));
+		hr = SetDailyTriggerStartBoundary(pDailyTrigger, startDate, dailyStartTime);
 		if (FAILED(hr)) {
-			printf("Could not set start time: %x\n", hr);
 			return hr;
 		}
 
@@ -195,11 +325,262 @@ namespace task_scheduler {
 			FormatDateString(timespec, DATE_FORMAT_STRING_SIZE, endDate);
 			hr = pDailyTrigger->put_EndBoundary(_bstr_t(timespec));
 			if (FAILED(hr)) {
-				printf("Could not set end time: %x\n", hr);
+				fprintf(stderr, "Could not set end time: %x\n", hr);
+				return hr;
+			}
+		}
+
+		return S_OK;
+	}
+
+	HRESULT AddTaskCompletionTrigger(const CComPtr<ITaskDefinition> &pTask, const std::wstring &prerequisite,
+		const DateSpec &startDate, const DateSpec &endDate)
+	{
+		CComPtr<ITriggerCollection> pTriggerCollection;
+		CComPtr<ITrigger> pTrigger;
+		CComPtr<IEventTrigger> pEventTrigger;
+		wchar_t timespec[DATE_FORMAT_STRING_SIZE];
+
+		HRESULT hr = pTask->get_Triggers(&pTriggerCollection);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not get trigger collection: %x\n", hr);
+			return hr;
+		}
+
+		hr = pTriggerCollection->Create(TASK_TRIGGER_EVENT, &pTrigger);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not create event trigger: %x\n", hr);
+			return hr;
+		}
+
+		hr = pTrigger.QueryInterface(&pEventTrigger);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not query event trigger interface: %x\n", hr);
+			return hr;
+		}
+		pTrigger.Release();
+
+		// Set trigger id, to tell the triggers apart
+		std::wstring id = L"After " + prerequisite;
+		hr = pEventTrigger->put_Id(_bstr_t(id.c_str()));
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not set trigger id: %x\n", hr);
+		}
+
+		std::wstring query;
+		BuildTaskCompletionQuery(query, prerequisite);
+		hr = pEventTrigger->put_Subscription(_bstr_t(query.c_str()));
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not set event subscription: %x\n", hr);
+			return hr;
+		}
+
+		// The dates still limit when the task runs (optional)
+		if (startDate.GetYear()) {
+			FormatDateString(timespec, DATE_FORMAT_STRING_SIZE, startDate);
+			hr = pEventTrigger->put_StartBoundary(_bstr_t(timespec));
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not set start time: %x\n", hr);
+				return hr;
+			}
+		}
+
+		if (endDate.GetYear()) {
+			FormatDateString(timespec, DATE_FORMAT_STRING_SIZE, endDate);
+			hr = pEventTrigger->put_EndBoundary(_bstr_t(timespec));
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not set end time: %x\n", hr);
 				return hr;
 			}
 		}
 
 		return S_OK;
 	}
-}
\ No newline at end of file
+
+	void BuildTaskCompletionQuery(std::wstring &dst, const std::wstring &taskName)
+	{
+		static const wchar_t OPERATIONAL_LOG[] = L"Microsoft-Windows-TaskScheduler/Operational";
+
+		// Event 201 is logged when a task's action completes, along with its exit code.
+		// The task name is in double quotes in the XPath, and escaped for the surrounding XML.
+		dst = L"<QueryList><Query Id=\"0\" Path=\"";
+		dst += OPERATIONAL_LOG;
+		dst += L"\"><Select Path=\"";
+		dst += OPERATIONAL_LOG;
+		dst += L"\">*[System[EventID=201]] and *[EventData[Data[@Name='TaskName']=&quot;\\";
+		for (size_t i = 0; i < taskName.size(); i++) {
+			switch (taskName[i]) {
+			case L'&': dst += L"&amp;"; break;
+			case L'<': dst += L"&lt;"; break;
+			case L'>': dst += L"&gt;"; break;
+			case L'"': dst += L"&quot;"; break;
+			default: dst += taskName[i]; break;
+			}
+		}
+		dst += L"&quot;] and EventData[Data[@Name='ResultCode']='0']]</Select></Query></QueryList>";
+	}
+
+	HRESULT SetDailyTriggerStartBoundary(const CComPtr<IDailyTrigger> &pDailyTrigger, const DateSpec &startDate,
+		const TimeSpec &dailyStartTime)
+	{
+		wchar_t timespec[DATE_FORMAT_STRING_SIZE];
+		FormatDateString(timespec, DATE_FORMAT_STRING_SIZE, startDate, dailyStartTime);
+		HRESULT hr = pDailyTrigger->put_StartBoundary(_bstr_t(timespec));
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not set start time: %x\n", hr);
+		}
+		return hr;
+	}
+
+	HRESULT GetTaskExecAction(const CComPtr<ITaskDefinition> &pTask, CComPtr<IExecAction> &pExecAction)
+	{
+		CComPtr<IActionCollection> pActions;
+		HRESULT hr = pTask->get_Actions(&pActions);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not get action collection for task: %x\n", hr);
+			return hr;
+		}
+
+		// Collection indices start from 1
+		CComPtr<IAction> pAction;
+		hr = pActions->get_Item(1, &pAction);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not get task action: %x\n", hr);
+			return hr;
+		}
+
+		return pAction.QueryInterface(&pExecAction);
+	}
+
+	HRESULT SetDailyTriggersStartTime(const CComPtr<ITaskDefinition> &pTask, const TimeSpec &dailyStartTime)
+	{
+		CComPtr<ITriggerCollection> pTriggerCollection;
+		HRESULT hr = pTask->get_Triggers(&pTriggerCollection);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not get trigger collection: %x\n", hr);
+			return hr;
+		}
+
+		LONG count = 0;
+		hr = pTriggerCollection->get_Count(&count);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not get trigger count: %x\n", hr);
+			return hr;
+		}
+
+		// Collection indices start from 1
+		bool found = false;
+		for (LONG i = 1; i <= count; i++) {
+			CComPtr<ITrigger> pTrigger;
+			TASK_TRIGGER_TYPE2 type = TASK_TRIGGER_EVENT;
+			hr = pTriggerCollection->get_Item(i, &pTrigger);
+			if (SUCCEEDED(hr)) {
+				hr = pTrigger->get_Type(&type);
+			}
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not get task trigger: %x\n", hr);
+				return hr;
+			}
+			if (type != TASK_TRIGGER_DAILY) {
+				continue;
+			}
+
+			// The boundary starts with the date as YYYY-MM-DD, followed by the time
+			CComBSTR boundary;
+			hr = pTrigger->get_StartBoundary(&boundary);
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not get trigger start boundary: %x\n", hr);
+				return hr;
+			}
+			std::wstring dateStr(boundary ? boundary.m_str : L"", boundary ? std::min<unsigned int>(boundary.Length(), 10u) : 0);
+			std::replace(dateStr.begin(), dateStr.end(), L'-', L'/');
+			DateSpec startDate;
+			if (!ParseDateString(startDate, dateStr.c_str())) {
+				fprintf(stderr, "Could not parse trigger start boundary: %S\n", boundary.m_str);
+				return E_UNEXPECTED;
+			}
+
+			wchar_t timespec[DATE_FORMAT_STRING_SIZE];
+			FormatDateString(timespec, DATE_FORMAT_STRING_SIZE, startDate, dailyStartTime);
+			hr = pTrigger->put_StartBoundary(_bstr_t(timespec));
+			if (FAILED(hr)) {
+				fprintf(stderr, "Could not set start time: %x\n", hr);
+				return hr;
+			}
+			found = true;
+		}
+
+		return found ? S_OK : S_FALSE;
+	}
+
+	HRESULT GetTaskDailyTrigger(const CComPtr<ITaskDefinition> &pTask, CComPtr<IDailyTrigger> &pDailyTrigger)
+	{
+		CComPtr<ITriggerCollection> pTriggerCollection;
+		HRESULT hr = pTask->get_Triggers(&pTriggerCollection);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not get trigger collection: %x\n", hr);
+			return hr;
+		}
+
+		// Collection indices start from 1
+		CComPtr<ITrigger> pTrigger;
+		hr = pTriggerCollection->get_Item(1, &pTrigger);
+		if (FAILED(hr)) {
+			fprintf(stderr, "Could not get task trigger: %x\n", hr);
+			return hr;
+		}
+
+		return pTrigger.QueryInterface(&pDailyTrigger);
+	}
+
+	void FoldTaskName(std::wstring &dst, const std::wstring &taskName)
+	{
+		dst.resize(taskName.size());
+		for (size_t i = 0; i < taskName.size(); i++) {
+			dst[i] = (wchar_t)towlower(taskName[i]);
+		}
+	}
+
+	bool Utf8ToWide(std::wstring &dst, const char *str)
+	{
+		if (!str) {
+			return false;
+		}
+
+		int len = (int)strlen(str);
+		if (len == 0) {
+			dst.clear();
+			return true;
+		}
+
+		// Calculate the size once, then convert directly into the destination
+		int wlen = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, len, NULL, 0);
+		if (wlen <= 0) {
+			return false;
+		}
+
+		dst.resize(wlen);
+		return MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, len, &dst[0], wlen) == wlen;
+	}
+
+	bool WideToUtf8(std::string &dst, const wchar_t *str, size_t length)
+	{
+		if (!str) {
+			return false;
+		}
+
+		int len = (int)length;
+		if (len == 0) {
+			dst.clear();
+			return true;
+		}
+
+		int size = WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, str, len, NULL, 0, NULL, NULL);
+		if (size <= 0) {
+			return false;
+		}
+
+		dst.resize(size);
+		return WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, str, len, &dst[0], size, NULL, NULL) == size;
+	}
+}
@@ -9,20 +9,76 @@ namespace task_scheduler {
 	// Create a task with a trigger
 	// pTask will be created if this function returns S_OK
 	HRESULT CreateDailyTaskWithTrigger(const CComPtr<ITaskService> &pTaskSvc, CComPtr<ITaskDefinition> &pTask,
-		const DateSpec &startDate, const DateSpec &endDate, const TimeSpec &dailyStartTime);
+		const DateSpec &startDate, const DateSpec &endDate, const TimeSpec &dailyStartTime,
+		const TaskSettings &settings);
+
+	// Create a task with a daily trigger for each run of days that aren't blacked out in the calendar,
+	// from today or the start date, whichever is later
+	// pTask will be created if this function returns S_OK
+	HRESULT CreateDailyTaskWithBlackout(const CComPtr<ITaskService> &pTaskSvc, CComPtr<ITaskDefinition> &pTask,
+		const DateSpec &startDate, const DateSpec &endDate, const TimeSpec &dailyStartTime,
+		const TaskSettings &settings, const BlackoutCalendar &calendar);
+
+	// Create a task that runs each time one of the given tasks completes successfully
+	// pTask will be created if this function returns S_OK
+	HRESULT CreateTaskWithCompletionTriggers(const CComPtr<ITaskService> &pTaskSvc, CComPtr<ITaskDefinition> &pTask,
+		const DateSpec &startDate, const DateSpec &endDate, const std::vector<std::wstring> &prerequisites,
+		const TaskSettings &settings);
 
 	// Create an executable action on the given task
 	HRESULT CreateExecActionOnTask(const CComPtr<ITaskDefinition> &pTask, const wchar_t *taskExePath,
 		const wchar_t **taskArgv, int32_t taskArgc);
 
+	// Create an executable action on the given task, with the arguments already joined into one string
+	// taskArgs may be NULL or empty, if there are no arguments
+	HRESULT CreateExecActionOnTask(const CComPtr<ITaskDefinition> &pTask, const wchar_t *taskExePath,
+		const wchar_t *taskArgs);
+
 	// Set the logon type for a task
 	HRESULT SetTaskLogonType(const CComPtr<ITaskDefinition> &pTask, TASK_LOGON_TYPE logonType);
 
 	// Set the task settings
-	HRESULT SetTaskSettings(const CComPtr<ITaskDefinition> &pTask, bool startWhenAvailable);
+	HRESULT SetTaskSettings(const CComPtr<ITaskDefinition> &pTask, const TaskSettings &settings);
+
+	// Format a number of seconds as an XML duration with every field, e.g. P0DT1H30M0S, as used by the task service
+	void FormatDuration(std::wstring &dst, uint32_t seconds);
 
 	// Create a trigger for the task
+	// Tasks with several daily triggers give each a number from 1, so that their ids are distinct
 	HRESULT SetTaskDailyTrigger(const CComPtr<ITaskDefinition> &pTask, const DateSpec &startDate,
-		const DateSpec &endDate, const TimeSpec &dailyStartTime);
+		const DateSpec &endDate, const TimeSpec &dailyStartTime, uint32_t number = 0);
+
+	// Create a trigger that starts the task when the given task in the default folder completes successfully
+	// This relies on the task service's operational event log, i.e. task history must be enabled
+	HRESULT AddTaskCompletionTrigger(const CComPtr<ITaskDefinition> &pTask, const std::wstring &prerequisite,
+		const DateSpec &startDate, const DateSpec &endDate);
+
+	// Build the event query that matches the successful completion of the given task in the default folder
+	void BuildTaskCompletionQuery(std::wstring &dst, const std::wstring &taskName);
+
+	// Set the start boundary of a daily trigger, i.e. the first date and the time of day to run
+	HRESULT SetDailyTriggerStartBoundary(const CComPtr<IDailyTrigger> &pDailyTrigger, const DateSpec &startDate,
+		const TimeSpec &dailyStartTime);
+
+	// Set the time of day of every daily trigger of a task, keeping the date each starts on
+	// Returns S_FALSE if the task has no daily triggers
+	HRESULT SetDailyTriggersStartTime(const CComPtr<ITaskDefinition> &pTask, const TimeSpec &dailyStartTime);
+
+	// Get the (first) executable action of a task, as created by CreateExecActionOnTask
+	HRESULT GetTaskExecAction(const CComPtr<ITaskDefinition> &pTask, CComPtr<IExecAction> &pExecAction);
+
+	// Get the (first) daily trigger of a task, as created by SetTaskDailyTrigger
+	HRESULT GetTaskDailyTrigger(const CComPtr<ITaskDefinition> &pTask, CComPtr<IDailyTrigger> &pDailyTrigger);
+
+	// Fold the case of a task name, so that names can be compared ignoring case, as the task service does
+	void FoldTaskName(std::wstring &dst, const std::wstring &taskName);
+
+	// Convert a null-terminated UTF-8 string to UTF-16
+	// Returns false if str is NULL or is not valid UTF-8
+	bool Utf8ToWide(std::wstring &dst, const char *str);
+
+	// Convert UTF-16 to UTF-8
+	// Returns false if str is NULL or is not valid UTF-16
+	bool WideToUtf8(std::string &dst, const wchar_t *str, size_t length);
 
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * What the task service does when a task is triggered while a previous run is still going.
+	 * These map directly to TASK_INSTANCES_POLICY.
+	 */
+	enum InstancesPolicy {
+		INSTANCES_IGNORE_NEW,	// Don't start the new run (the task service default)
+		INSTANCES_QUEUE,		// Start the new run once the previous one has finished
+		INSTANCES_STOP_EXISTING,// Stop the previous run before starting the new one
+		INSTANCES_PARALLEL		// Start the new run alongside the previous one
+	};
+
+	/**
+	 * Limits on how a task is run. These are enforced by the task service itself, so a runaway
+	 * run is stopped without any watcher process of our own.
+	 */
+	struct TaskSettings
+	{
+		// Keep the task service's default execution time limit (72 hours)
+		static const int32_t DEFAULT_EXECUTION_TIME_LIMIT = -1;
+		// Let runs take as long as they need
+		static const int32_t NO_EXECUTION_TIME_LIMIT = 0;
+		// Keep the task service's default priority (7, below normal)
+		static const int32_t DEFAULT_PRIORITY = -1;
+		// The most urgent and least urgent priorities the task service accepts
+		static const int32_t HIGHEST_PRIORITY = 0;
+		static const int32_t LOWEST_PRIORITY = 10;
+
+		// The longest a single run may take before it is stopped, in seconds
+		int32_t executionTimeLimit;
+		// What to do if the task is triggered while already running
+		InstancesPolicy instancesPolicy;
+		// Run as soon as possible after a missed start, e.g. if the machine was off. Turn this off for
+		// best-effort tasks whose runs are worthless once late, so that missed runs are skipped.
+		bool startWhenAvailable;
+		// How urgent runs are, from HIGHEST_PRIORITY to LOWEST_PRIORITY. The task service runs the
+		// process at the matching priority class (0 realtime, 1 high, 2-3 above normal, 4-6 normal,
+		// 7-8 below normal, 9-10 idle), so under load critical tasks get the machine first.
+		int32_t priority;
+
+		TaskSettings() : executionTimeLimit(DEFAULT_EXECUTION_TIME_LIMIT), instancesPolicy(INSTANCES_IGNORE_NEW),
+			startWhenAvailable(true), priority(DEFAULT_PRIORITY)
+		{
+		}
+
+		bool operator==(const TaskSettings &other) const
+		{
+			return executionTimeLimit == other.executionTimeLimit && instancesPolicy == other.instancesPolicy &&
+				startWhenAvailable == other.startWhenAvailable && priority == other.priority;
+		}
+
+		bool operator!=(const TaskSettings &other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+}
@@ -0,0 +1,376 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+#include <atomic>
+#include <cwctype>
+
+namespace task_scheduler {
+
+	// The shared memory starts with a header, followed by the records (one per task), an open
+	// addressed hash table of record index + 1 (0 for an empty slot), and the task names.
+	static const uint32_t SNAPSHOT_MAGIC = 0x50534E54; // "TNSP"
+
+	// How long readers wait for a snapshot being published, before assuming the writer died part way
+	static const uint32_t READ_SPINS = 1000;
+	static const uint32_t READ_SLEEPS = 100; // Of 1 ms each, after spinning
+
+	struct SnapshotHeader
+	{
+		uint32_t magic;
+		uint32_t capacity;
+		// Odd while a snapshot is being written
+		std::atomic<uint32_t> sequence;
+		uint32_t count;
+		uint32_t slotCount;
+		uint32_t slotsOffset;
+		uint32_t namesOffset;
+		uint32_t reserved;
+	};
+
+	struct SnapshotRecord
+	{
+		int64_t nextRun;
+		int32_t lastResult;
+		uint32_t nameHash;
+		uint32_t nameOffset; // In characters, from the start of the names
+		uint32_t nameLength;
+	};
+
+	// FNV-1a hash of a task name, ignoring case like the task service
+	static uint32_t HashName(const wchar_t *str, size_t len)
+	{
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < len; i++) {
+			hash = (hash ^ (uint32_t)towlower(str[i])) * 16777619u;
+		}
+		return hash;
+	}
+
+	// Wait before retrying a read, returns false once the reader has waited long enough
+	static bool WaitToRetry(uint32_t &attempts)
+	{
+		if (attempts < READ_SPINS) {
+			YieldProcessor();
+		} else if (attempts < READ_SPINS + READ_SLEEPS) {
+			Sleep(1);
+		} else {
+			return false;
+		}
+		attempts++;
+		return true;
+	}
+
+	// Get the size of a mapped view, which is a whole number of pages
+	static size_t GetViewSize(const void *view)
+	{
+		MEMORY_BASIC_INFORMATION info;
+		if (!VirtualQuery(view, &info, sizeof(info))) {
+			return 0;
+		}
+		return info.RegionSize;
+	}
+
+	struct TaskSnapshotWriter::Impl
+	{
+		HANDLE mapping;
+		SnapshotHeader *header;
+
+		Impl() : mapping(NULL), header(NULL)
+		{
+		}
+
+		~Impl()
+		{
+			if (header) {
+				UnmapViewOfFile(header);
+			}
+			if (mapping) {
+				CloseHandle(mapping);
+			}
+		}
+	};
+
+	TaskSnapshotWriter::TaskSnapshotWriter() : impl(new Impl())
+	{
+	}
+
+	TaskSnapshotWriter::~TaskSnapshotWriter()
+	{
+		delete impl;
+	}
+
+	bool TaskSnapshotWriter::Create(const wchar_t *name, uint32_t capacity)
+	{
+		if (impl->header || capacity < sizeof(SnapshotHeader)) {
+			return false;
+		}
+
+		impl->mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, capacity, name);
+		if (!impl->mapping) {
+			fprintf(stderr, "Could not create snapshot %S: %x\n", name, GetLastError());
+			return false;
+		}
+		bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+
+		impl->header = (SnapshotHeader *)MapViewOfFile(impl->mapping, FILE_MAP_WRITE, 0, 0, 0);
+		if (!impl->header) {
+			fprintf(stderr, "Could not map snapshot %S: %x\n", name, GetLastError());
+			CloseHandle(impl->mapping);
+			impl->mapping = NULL;
+			return false;
+		}
+
+		// A previous writer's snapshot may still be open by readers, in which case carry on from
+		// its sequence number, with its capacity. If that writer died part way through publishing,
+		// the sequence is odd, so make it even: what it wrote is then readable, if incomplete, and
+		// the next Publish marks the snapshot as being written again.
+		SnapshotHeader *header = impl->header;
+		if (existed && header->magic == SNAPSHOT_MAGIC && header->capacity <= GetViewSize(header)) {
+			uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+			if (sequence & 1) {
+				header->sequence.store(sequence + 1, std::memory_order_release);
+			}
+			return true;
+		}
+
+		header->magic = SNAPSHOT_MAGIC;
+		header->capacity = existed ? (uint32_t)std::min<size_t>(GetViewSize(header), capacity) : capacity;
+		header->sequence.store(0, std::memory_order_relaxed);
+		header->count = 0;
+		header->slotCount = 0;
+		header->slotsOffset = sizeof(SnapshotHeader);
+		header->namesOffset = sizeof(SnapshotHeader);
+		std::atomic_thread_fence(std::memory_order_release);
+		return true;
+	}
+
+	bool TaskSnapshotWriter::Publish(const TaskTable &table, const TaskSnapshotEntry *entries)
+	{
+		SnapshotHeader *header = impl->header;
+		if (!header) {
+			return false;
+		}
+
+		// Size the hash table to at most half full, and check that everything fits
+		uint32_t count = table.Size();
+		uint32_t slotCount = 0;
+		if (count) {
+			slotCount = 4;
+			while (slotCount < count * 2) {
+				slotCount *= 2;
+			}
+		}
+		uint64_t nameChars = 0;
+		for (uint32_t row = 0; row < count; row++) {
+			nameChars += wcslen(table.GetName(row));
+		}
+		uint64_t slotsOffset = sizeof(SnapshotHeader) + (uint64_t)count * sizeof(SnapshotRecord);
+		uint64_t namesOffset = slotsOffset + (uint64_t)slotCount * sizeof(uint32_t);
+		if (namesOffset + nameChars * sizeof(wchar_t) > header->capacity) {
+			fprintf(stderr, "Snapshot of %u tasks does not fit in %u bytes\n", count, header->capacity);
+			return false;
+		}
+
+		// Mark the snapshot as being written, so that readers retry
+		uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+		header->sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		uint8_t *base = (uint8_t *)header;
+		SnapshotRecord *records = (SnapshotRecord *)(base + sizeof(SnapshotHeader));
+		uint32_t *slots = (uint32_t *)(base + slotsOffset);
+		wchar_t *names = (wchar_t *)(base + namesOffset);
+
+		header->count = count;
+		header->slotCount = slotCount;
+		header->slotsOffset = (uint32_t)slotsOffset;
+		header->namesOffset = (uint32_t)namesOffset;
+		memset(slots, 0, slotCount * sizeof(uint32_t));
+
+		uint32_t nameOffset = 0;
+		for (uint32_t row = 0; row < count; row++) {
+			const wchar_t *name = table.GetName(row);
+			uint32_t length = (uint32_t)wcslen(name);
+			memcpy(names + nameOffset, name, length * sizeof(wchar_t));
+
+			SnapshotRecord &record = records[row];
+			record.nextRun = entries[row].nextRun;
+			record.lastResult = entries[row].lastResult;
+			record.nameHash = HashName(name, length);
+			record.nameOffset = nameOffset;
+			record.nameLength = length;
+			nameOffset += length;
+
+			uint32_t slot = record.nameHash & (slotCount - 1);
+			while (slots[slot]) {
+				slot = (slot + 1) & (slotCount - 1);
+			}
+			slots[slot] = row + 1;
+		}
+
+		header->sequence.store(sequence + 2, std::memory_order_release);
+		return true;
+	}
+
+	struct TaskSnapshotReader::Impl
+	{
+		HANDLE mapping;
+		const SnapshotHeader *header;
+		uint32_t capacity;
+		bool timedOut;
+
+		Impl() : mapping(NULL), header(NULL), capacity(0), timedOut(false)
+		{
+		}
+
+		~Impl()
+		{
+			if (header) {
+				UnmapViewOfFile(header);
+			}
+			if (mapping) {
+				CloseHandle(mapping);
+			}
+		}
+
+		// Look up a task in the snapshot as it is now. The snapshot may be written concurrently,
+		// so every offset is checked before it is used, and the caller checks the sequence after.
+		bool Lookup(const wchar_t *taskName, size_t length, uint32_t hash, TaskSnapshotEntry &entry) const
+		{
+			const uint8_t *base = (const uint8_t *)header;
+			uint32_t count = header->count;
+			uint32_t slotCount = header->slotCount;
+			uint64_t slotsOffset = header->slotsOffset;
+			uint64_t namesOffset = header->namesOffset;
+			if (slotCount == 0 || (slotCount & (slotCount - 1)) != 0 ||
+				sizeof(SnapshotHeader) + (uint64_t)count * sizeof(SnapshotRecord) > slotsOffset ||
+				slotsOffset + (uint64_t)slotCount * sizeof(uint32_t) > namesOffset || namesOffset > capacity) {
+				return false;
+			}
+
+			const SnapshotRecord *records = (const SnapshotRecord *)(base + sizeof(SnapshotHeader));
+			const uint32_t *slots = (const uint32_t *)(base + slotsOffset);
+			const wchar_t *names = (const wchar_t *)(base + namesOffset);
+			uint64_t nameChars = (capacity - namesOffset) / sizeof(wchar_t);
+
+			uint32_t slot = hash & (slotCount - 1);
+			for (uint32_t probes = 0; probes < slotCount && slots[slot]; probes++) {
+				uint32_t index = slots[slot] - 1;
+				if (index < count) {
+					const SnapshotRecord &record = records[index];
+					if (record.nameHash == hash && record.nameLength == length &&
+						(uint64_t)record.nameOffset + length <= nameChars &&
+						_wcsnicmp(names + record.nameOffset, taskName, length) == 0) {
+						entry.nextRun = record.nextRun;
+						entry.lastResult = record.lastResult;
+						return true;
+					}
+				}
+				slot = (slot + 1) & (slotCount - 1);
+			}
+			return false;
+		}
+	};
+
+	TaskSnapshotReader::TaskSnapshotReader() : impl(new Impl())
+	{
+	}
+
+	TaskSnapshotReader::~TaskSnapshotReader()
+	{
+		delete impl;
+	}
+
+	bool TaskSnapshotReader::Open(const wchar_t *name)
+	{
+		if (impl->header) {
+			return false;
+		}
+
+		impl->mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, name);
+		if (!impl->mapping) {
+			return false;
+		}
+
+		impl->header = (const SnapshotHeader *)MapViewOfFile(impl->mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!impl->header) {
+			CloseHandle(impl->mapping);
+			impl->mapping = NULL;
+			return false;
+		}
+
+		if (impl->header->magic != SNAPSHOT_MAGIC || impl->header->capacity > GetViewSize(impl->header)) {
+			UnmapViewOfFile(impl->header);
+			impl->header = NULL;
+			CloseHandle(impl->mapping);
+			impl->mapping = NULL;
+			return false;
+		}
+		impl->capacity = impl->header->capacity;
+		return true;
+	}
+
+	bool TaskSnapshotReader::Find(const wchar_t *taskName, TaskSnapshotEntry &entry) const
+	{
+		if (!impl->capacity || !taskName) {
+			return false;
+		}
+
+		size_t length = wcslen(taskName);
+		uint32_t hash = HashName(taskName, length);
+		impl->timedOut = false;
+		for (uint32_t attempts = 0; ; ) {
+			uint32_t sequence = impl->header->sequence.load(std::memory_order_acquire);
+			if (sequence & 1) {
+				if (!WaitToRetry(attempts)) {
+					impl->timedOut = true;
+					return false;
+				}
+				continue;
+			}
+
+			TaskSnapshotEntry found;
+			bool exists = impl->Lookup(taskName, length, hash, found);
+
+			// Only trust what was read if no snapshot was published in the meantime
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (impl->header->sequence.load(std::memory_order_relaxed) == sequence) {
+				if (exists) {
+					entry = found;
+				}
+				return exists;
+			}
+			if (!WaitToRetry(attempts)) {
+				impl->timedOut = true;
+				return false;
+			}
+		}
+	}
+
+	uint32_t TaskSnapshotReader::Size() const
+	{
+		if (!impl->capacity) {
+			return 0;
+		}
+
+		impl->timedOut = false;
+		for (uint32_t attempts = 0; ; ) {
+			uint32_t sequence = impl->header->sequence.load(std::memory_order_acquire);
+			uint32_t count = impl->header->count;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (!(sequence & 1) && impl->header->sequence.load(std::memory_order_relaxed) == sequence) {
+				return count;
+			}
+			if (!WaitToRetry(attempts)) {
+				impl->timedOut = true;
+				return 0;
+			}
+		}
+	}
+
+	bool TaskSnapshotReader::TimedOut() const
+	{
+		return impl->timedOut;
+	}
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * What a task snapshot holds for each task
+	 */
+	struct TaskSnapshotEntry
+	{
+		/**
+		 * The next run time, in local seconds since 1970-01-01 (see GetNextDailyRuns), or NO_NEXT_RUN
+		 */
+		int64_t nextRun;
+
+		/**
+		 * The result of the last run as reported by the task service, i.e. the exit code of the
+		 * executable, or SCHED_S_TASK_HAS_NOT_RUN
+		 */
+		int32_t lastResult;
+	};
+
+	/**
+	 * Publishes the names, next run times and last results of a table of tasks into named shared
+	 * memory, so that other local processes can look them up with TaskSnapshotReader without any
+	 * system calls or round trips to the task service.
+	 * Each snapshot is versioned with a sequence lock: readers retry if a snapshot is published
+	 * while they are reading, so publishing never waits for readers. Task names ignore case.
+	 */
+	class TASKSCHEDULER_EXPORT TaskSnapshotWriter
+	{
+		struct Impl;
+		Impl *impl;
+
+	public:
+		TaskSnapshotWriter();
+		~TaskSnapshotWriter();
+
+		TaskSnapshotWriter(const TaskSnapshotWriter &) = delete;
+		TaskSnapshotWriter &operator=(const TaskSnapshotWriter &) = delete;
+
+		/**
+		 * Create the shared memory, with an empty snapshot. If a previous writer's shared memory is
+		 * still open by readers it is reused, along with its last snapshot.
+		 * @param name The name of the file mapping, e.g. L"Local\\TaskSchedulerSnapshot"
+		 * @param capacity The size of the shared memory in bytes, which limits the number of tasks and
+		 * the length of their names. Each task takes 32 bytes plus its name.
+		 * @returns true if the shared memory was created
+		 */
+		bool Create(const wchar_t *name, uint32_t capacity);
+
+		/**
+		 * Publish a new snapshot, replacing the previous one.
+		 * @param table The tasks to publish
+		 * @param entries The next run and last result of each row of the table
+		 * @returns false if the snapshot does not fit in the shared memory, or it hasn't been created
+		 */
+		bool Publish(const TaskTable &table, const TaskSnapshotEntry *entries);
+	};
+
+	/**
+	 * Looks up tasks in a snapshot published by TaskSnapshotWriter, possibly in another process
+	 */
+	class TASKSCHEDULER_EXPORT TaskSnapshotReader
+	{
+		struct Impl;
+		Impl *impl;
+
+	public:
+		TaskSnapshotReader();
+		~TaskSnapshotReader();
+
+		TaskSnapshotReader(const TaskSnapshotReader &) = delete;
+		TaskSnapshotReader &operator=(const TaskSnapshotReader &) = delete;
+
+		/**
+		 * Open the shared memory of a snapshot, see TaskSnapshotWriter::Create
+		 * @returns true if the snapshot exists
+		 */
+		bool Open(const wchar_t *name);
+
+		/**
+		 * Look up a task in the current snapshot
+		 * @param taskName The name of the task, in any case
+		 * @param entry [out] The next run and last result of the task
+		 * @returns true if the task is in the snapshot, false if it isn't or TimedOut
+		 */
+		bool Find(const wchar_t *taskName, TaskSnapshotEntry &entry) const;
+
+		/**
+		 * Get the number of tasks in the current snapshot, or 0 if TimedOut
+		 */
+		uint32_t Size() const;
+
+		/**
+		 * Test if the last Find or Size gave up waiting, after about 100 ms, for a snapshot to
+		 * finish being published, e.g. as the writer died part way through
+		 */
+		bool TimedOut() const;
+	};
+
+}
@@ -0,0 +1,469 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+#include <cwctype>
+
+namespace task_scheduler {
+
+	// FNV-1a hash of a string
+	static uint32_t HashString(const wchar_t *str, size_t len)
+	{
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < len; i++) {
+			hash = (hash ^ (uint32_t)str[i]) * 16777619u;
+		}
+		return hash;
+	}
+
+	// FNV-1a hash of a string, ignoring case
+	static uint32_t HashStringIgnoreCase(const wchar_t *str, size_t len)
+	{
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < len; i++) {
+			hash = (hash ^ (uint32_t)towlower(str[i])) * 16777619u;
+		}
+		return hash;
+	}
+
+	// FNV-1a hash of some bytes, continuing from a previous hash
+	static uint64_t HashBytes(uint64_t hash, const void *data, size_t size)
+	{
+		const uint8_t *bytes = (const uint8_t *)data;
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static uint64_t HashWideString(uint64_t hash, const wchar_t *str, size_t len)
+	{
+		// Include the terminator, so that adjacent strings can't run into each other
+		return HashBytes(hash, str, (len + 1) * sizeof(wchar_t));
+	}
+
+	// Hash everything about a task that is registered with the task service, other than its name
+	static uint64_t HashContent(const TaskDefinition &task)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		hash = HashWideString(hash, task.GetExecutable().c_str(), task.GetExecutable().size());
+		hash = HashWideString(hash, task.GetArguments(), wcslen(task.GetArguments()));
+
+		int32_t schedule[] = {
+			DateToDays(task.GetStartDate()), task.GetStartDate().GetYear(),
+			DateToDays(task.GetEndDate()), task.GetEndDate().GetYear(),
+			task.GetDailyStartTime().GetTotalSeconds(), (int32_t)task.GetSpreadWindow()
+		};
+		hash = HashBytes(hash, schedule, sizeof(schedule));
+
+		const TaskSettings &settings = task.GetSettings();
+		int32_t packedSettings[] = {
+			settings.executionTimeLimit, (int32_t)settings.instancesPolicy, settings.startWhenAvailable ? 1 : 0,
+			settings.priority
+		};
+		hash = HashBytes(hash, packedSettings, sizeof(packedSettings));
+
+		const std::vector<std::wstring> &dependencies = task.GetDependencies();
+		for (size_t i = 0; i < dependencies.size(); i++) {
+			hash = HashWideString(hash, dependencies[i].c_str(), dependencies[i].size());
+		}
+
+		if (task.GetBlackoutCalendar()) {
+			uint64_t calendarHash = task.GetBlackoutCalendar()->GetContentHash();
+			hash = HashBytes(hash, &calendarHash, sizeof(calendarHash));
+		}
+		return hash;
+	}
+
+	static int32_t PackStartDate(const DateSpec &date)
+	{
+		return date.GetYear() ? DateToDays(date) : NO_START_DAY;
+	}
+
+	static int32_t PackEndDate(const DateSpec &date)
+	{
+		return date.GetYear() ? DateToDays(date) : NO_END_DAY;
+	}
+
+	static DateSpec UnpackDate(int32_t days)
+	{
+		return (days == NO_START_DAY || days == NO_END_DAY) ? DateSpec() : DaysToDate(days);
+	}
+
+	static TimeSpec UnpackTime(int32_t seconds)
+	{
+		return TimeSpec((uint8_t)(seconds / 3600), (uint8_t)((seconds / 60) % 60), (uint8_t)(seconds % 60));
+	}
+
+	template <typename T>
+	static size_t VectorBytes(const std::vector<T> &v)
+	{
+		return v.capacity() * sizeof(T);
+	}
+
+	// Interns null-terminated strings into a single arena, assigning each distinct string a dense id.
+	// Strings are never removed, so ids stay valid until the pool is cleared.
+	// A pool that ignores case keeps the spelling each string was most recently interned with.
+	class StringPool
+	{
+		bool ignoreCase;
+		std::vector<wchar_t> chars;
+		std::vector<uint32_t> offsets; // id -> offset of the string in chars
+		std::vector<uint32_t> hashes; // id -> hash of the string
+		std::vector<uint32_t> slots; // Open addressed hash table of id + 1, 0 for an empty slot
+
+		bool Equals(uint32_t id, const wchar_t *str, size_t len) const
+		{
+			const wchar_t *existing = &chars[offsets[id]];
+			if (ignoreCase) {
+				return _wcsnicmp(existing, str, len) == 0 && existing[len] == 0;
+			}
+			return wcsncmp(existing, str, len) == 0 && existing[len] == 0;
+		}
+
+		void Grow()
+		{
+			std::vector<uint32_t> newSlots(slots.empty() ? 64 : slots.size() * 2, 0);
+			size_t mask = newSlots.size() - 1;
+			for (uint32_t id = 0; id < (uint32_t)hashes.size(); id++) {
+				size_t i = hashes[id] & mask;
+				while (newSlots[i]) {
+					i = (i + 1) & mask;
+				}
+				newSlots[i] = id + 1;
+			}
+			slots.swap(newSlots);
+		}
+
+	public:
+		static const uint32_t INVALID_ID = 0xFFFFFFFF;
+
+		explicit StringPool(bool ignoreCase = false) : ignoreCase(ignoreCase)
+		{
+		}
+
+		uint32_t Hash(const wchar_t *str, size_t len) const
+		{
+			return ignoreCase ? HashStringIgnoreCase(str, len) : HashString(str, len);
+		}
+
+		uint32_t Find(const wchar_t *str, size_t len, uint32_t hash) const
+		{
+			if (slots.empty()) {
+				return INVALID_ID;
+			}
+
+			size_t mask = slots.size() - 1;
+			for (size_t i = hash & mask; slots[i]; i = (i + 1) & mask) {
+				uint32_t id = slots[i] - 1;
+				if (hashes[id] == hash && Equals(id, str, len)) {
+					return id;
+				}
+			}
+			return INVALID_ID;
+		}
+
+		uint32_t Intern(const wchar_t *str, size_t len)
+		{
+			uint32_t hash = Hash(str, len);
+			uint32_t id = Find(str, len, hash);
+			if (id != INVALID_ID) {
+				if (ignoreCase) {
+					// Equal ignoring case, so the same length
+					std::copy(str, str + len, chars.begin() + offsets[id]);
+				}
+				return id;
+			}
+
+			// Keep the load factor at or below 1/2
+			if ((hashes.size() + 1) * 2 > slots.size()) {
+				Grow();
+			}
+
+			id = (uint32_t)hashes.size();
+			offsets.push_back((uint32_t)chars.size());
+			hashes.push_back(hash);
+			chars.insert(chars.end(), str, str + len);
+			chars.push_back(0);
+
+			size_t mask = slots.size() - 1;
+			size_t i = hash & mask;
+			while (slots[i]) {
+				i = (i + 1) & mask;
+			}
+			slots[i] = id + 1;
+			return id;
+		}
+
+		const wchar_t *Get(uint32_t id) const
+		{
+			return &chars[offsets[id]];
+		}
+
+		void Reserve(size_t count, size_t averageLength)
+		{
+			offsets.reserve(count);
+			hashes.reserve(count);
+			chars.reserve(count * (averageLength + 1));
+			while (count * 2 > slots.size()) {
+				Grow();
+			}
+		}
+
+		void Clear()
+		{
+			std::vector<wchar_t>().swap(chars);
+			std::vector<uint32_t>().swap(offsets);
+			std::vector<uint32_t>().swap(hashes);
+			std::vector<uint32_t>().swap(slots);
+		}
+
+		size_t GetMemoryUsage() const
+		{
+			return VectorBytes(chars) + VectorBytes(offsets) + VectorBytes(hashes) + VectorBytes(slots);
+		}
+	};
+
+	struct TaskTable::Impl
+	{
+		StringPool names;
+		StringPool strings; // Executable paths and arguments
+		std::vector<uint32_t> rowOfName; // name id -> row, or INVALID_ROW if removed
+
+		// Columns, indexed by row
+		std::vector<uint32_t> nameIds;
+		std::vector<uint32_t> exeIds;
+		std::vector<uint32_t> argIds;
+		std::vector<int32_t> startDays;
+		std::vector<int32_t> endDays;
+		std::vector<int32_t> startSeconds;
+		std::vector<uint64_t> contentHashes;
+
+		// Task names ignore case, as in the task service
+		Impl() : names(true)
+		{
+		}
+
+		uint32_t FindRow(const wchar_t *taskName) const
+		{
+			if (!taskName) {
+				return INVALID_ROW;
+			}
+			size_t len = wcslen(taskName);
+			uint32_t nameId = names.Find(taskName, len, names.Hash(taskName, len));
+			if (nameId == StringPool::INVALID_ID) {
+				return INVALID_ROW;
+			}
+			return rowOfName[nameId];
+		}
+	};
+
+	const uint32_t TaskTable::INVALID_ROW;
+
+	TaskTable::TaskTable() : impl(new Impl())
+	{
+	}
+
+	TaskTable::~TaskTable()
+	{
+		delete impl;
+	}
+
+	uint32_t TaskTable::Size() const
+	{
+		return (uint32_t)impl->nameIds.size();
+	}
+
+	void TaskTable::Reserve(uint32_t count)
+	{
+		// Names are usually distinct, executables and arguments are usually shared
+		impl->names.Reserve(count, 16);
+		impl->rowOfName.reserve(count);
+		impl->nameIds.reserve(count);
+		impl->exeIds.reserve(count);
+		impl->argIds.reserve(count);
+		impl->startDays.reserve(count);
+		impl->endDays.reserve(count);
+		impl->startSeconds.reserve(count);
+		impl->contentHashes.reserve(count);
+	}
+
+	void TaskTable::Clear()
+	{
+		delete impl;
+		impl = new Impl();
+	}
+
+	uint32_t TaskTable::Insert(const TaskDefinition &task)
+	{
+		const std::wstring &name = task.GetName();
+		uint32_t nameId = impl->names.Intern(name.c_str(), name.size());
+		if (nameId == impl->rowOfName.size()) {
+			impl->rowOfName.push_back(INVALID_ROW);
+		}
+
+		const std::wstring &exePath = task.GetExecutable();
+		const wchar_t *args = task.GetArguments();
+		uint32_t exeId = impl->strings.Intern(exePath.c_str(), exePath.size());
+		uint32_t argId = impl->strings.Intern(args, wcslen(args));
+
+		// Store the schedule the task is registered with, so next runs match the task service
+		DateSpec startDate;
+		TimeSpec dailyStartTime;
+		task.GetSpreadStart(startDate, dailyStartTime);
+		uint64_t contentHash = HashContent(task);
+
+		uint32_t row = impl->rowOfName[nameId];
+		if (row == INVALID_ROW) {
+			row = Size();
+			impl->rowOfName[nameId] = row;
+			impl->nameIds.push_back(nameId);
+			impl->exeIds.push_back(exeId);
+			impl->argIds.push_back(argId);
+			impl->startDays.push_back(PackStartDate(startDate));
+			impl->endDays.push_back(PackEndDate(task.GetEndDate()));
+			impl->startSeconds.push_back(dailyStartTime.GetTotalSeconds());
+			impl->contentHashes.push_back(contentHash);
+		} else {
+			impl->exeIds[row] = exeId;
+			impl->argIds[row] = argId;
+			impl->startDays[row] = PackStartDate(startDate);
+			impl->endDays[row] = PackEndDate(task.GetEndDate());
+			impl->startSeconds[row] = dailyStartTime.GetTotalSeconds();
+			impl->contentHashes[row] = contentHash;
+		}
+
+		return row;
+	}
+
+	uint32_t TaskTable::Find(const wchar_t *taskName) const
+	{
+		return impl->FindRow(taskName);
+	}
+
+	bool TaskTable::Remove(const wchar_t *taskName)
+	{
+		uint32_t row = impl->FindRow(taskName);
+		if (row == INVALID_ROW) {
+			return false;
+		}
+
+		// Move the last row into the removed row
+		uint32_t last = Size() - 1;
+		impl->rowOfName[impl->nameIds[row]] = INVALID_ROW;
+		if (row != last) {
+			impl->rowOfName[impl->nameIds[last]] = row;
+			impl->nameIds[row] = impl->nameIds[last];
+			impl->exeIds[row] = impl->exeIds[last];
+			impl->argIds[row] = impl->argIds[last];
+			impl->startDays[row] = impl->startDays[last];
+			impl->endDays[row] = impl->endDays[last];
+			impl->startSeconds[row] = impl->startSeconds[last];
+			impl->contentHashes[row] = impl->contentHashes[last];
+		}
+
+		impl->nameIds.pop_back();
+		impl->exeIds.pop_back();
+		impl->argIds.pop_back();
+		impl->startDays.pop_back();
+		impl->endDays.pop_back();
+		impl->startSeconds.pop_back();
+		impl->contentHashes.pop_back();
+		return true;
+	}
+
+	const wchar_t *TaskTable::GetName(uint32_t row) const
+	{
+		return impl->names.Get(impl->nameIds[row]);
+	}
+
+	const wchar_t *TaskTable::GetExecutable(uint32_t row) const
+	{
+		return impl->strings.Get(impl->exeIds[row]);
+	}
+
+	const wchar_t *TaskTable::GetArguments(uint32_t row) const
+	{
+		return impl->strings.Get(impl->argIds[row]);
+	}
+
+	DateSpec TaskTable::GetStartDate(uint32_t row) const
+	{
+		return UnpackDate(impl->startDays[row]);
+	}
+
+	DateSpec TaskTable::GetEndDate(uint32_t row) const
+	{
+		return UnpackDate(impl->endDays[row]);
+	}
+
+	TimeSpec TaskTable::GetDailyStartTime(uint32_t row) const
+	{
+		return UnpackTime(impl->startSeconds[row]);
+	}
+
+	DailyScheduleColumns TaskTable::GetScheduleColumns() const
+	{
+		DailyScheduleColumns columns;
+		columns.startDays = impl->startDays.data();
+		columns.endDays = impl->endDays.data();
+		columns.startSeconds = impl->startSeconds.data();
+		columns.count = impl->startSeconds.size();
+		return columns;
+	}
+
+	uint64_t TaskTable::GetContentHash(uint32_t row) const
+	{
+		return impl->contentHashes[row];
+	}
+
+	TaskDefinition TaskTable::GetDefinition(uint32_t row) const
+	{
+		TaskDefinition task;
+		task.SetName(GetName(row));
+		task.SetExecutable(GetExecutable(row));
+		task.SetArgumentString(GetArguments(row));
+		task.SetStartDate(GetStartDate(row));
+		task.SetEndDate(GetEndDate(row));
+		task.SetDailyStartTime(GetDailyStartTime(row));
+		return task;
+	}
+
+	size_t TaskTable::GetMemoryUsage() const
+	{
+		return sizeof(TaskTable) + sizeof(Impl) +
+			impl->names.GetMemoryUsage() + impl->strings.GetMemoryUsage() +
+			VectorBytes(impl->rowOfName) + VectorBytes(impl->nameIds) +
+			VectorBytes(impl->exeIds) + VectorBytes(impl->argIds) +
+			VectorBytes(impl->startDays) + VectorBytes(impl->endDays) +
+			VectorBytes(impl->startSeconds) + VectorBytes(impl->contentHashes);
+	}
+
+	double TaskTable::GetBytesPerTask() const
+	{
+		uint32_t size = Size();
+		return size ? (double)GetMemoryUsage() / size : 0.0;
+	}
+
+	void DiffTaskTables(const TaskTable &current, const TaskTable &next, TaskTableDiff &diff)
+	{
+		diff.inserted.clear();
+		diff.updated.clear();
+		diff.deleted.clear();
+
+		for (uint32_t row = 0; row < next.Size(); row++) {
+			uint32_t currentRow = current.Find(next.GetName(row));
+			if (currentRow == TaskTable::INVALID_ROW) {
+				diff.inserted.push_back(row);
+			} else if (current.GetContentHash(currentRow) != next.GetContentHash(row)) {
+				diff.updated.push_back(row);
+			}
+		}
+
+		for (uint32_t row = 0; row < current.Size(); row++) {
+			if (next.Find(current.GetName(row)) == TaskTable::INVALID_ROW) {
+				diff.deleted.push_back(row);
+			}
+		}
+	}
+
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * A compact in-memory table of daily executable tasks, keyed by task name.
+	 * Tasks are stored as a struct of arrays: each column is a dense array indexed by row, strings
+	 * are interned into shared arenas (so identical executables and arguments are stored once),
+	 * and dates and times are packed into 32-bit day and second counts (see DailyScheduleColumns). This
+	 * keeps the cost per task to a few dozen bytes plus the length of its name, for fleets of up to
+	 * millions of tasks.
+	 * NOTE: Rows are not stable, removing a task moves the last row into its place.
+	 */
+	class TASKSCHEDULER_EXPORT TaskTable
+	{
+		struct Impl;
+		Impl *impl;
+
+	public:
+		/**
+		 * The row index returned when a task could not be found
+		 */
+		static const uint32_t INVALID_ROW = 0xFFFFFFFF;
+
+		TaskTable();
+		~TaskTable();
+
+		TaskTable(const TaskTable &) = delete;
+		TaskTable &operator=(const TaskTable &) = delete;
+
+		/**
+		 * Get the number of tasks in the table
+		 */
+		uint32_t Size() const;
+
+		/**
+		 * Reserve space for the given number of tasks
+		 */
+		void Reserve(uint32_t count);
+
+		/**
+		 * Remove all tasks, and release the string arenas
+		 */
+		void Clear();
+
+		/**
+		 * Insert a task, replacing any existing task with the same name. Names ignore case, as in the
+		 * task service, and the row keeps the spelling of the name it was most recently inserted with.
+		 * @returns The row of the task
+		 */
+		uint32_t Insert(const TaskDefinition &task);
+
+		/**
+		 * Find a task by name, ignoring case.
+		 * @returns The row of the task, or INVALID_ROW if it does not exist
+		 */
+		uint32_t Find(const wchar_t *taskName) const;
+
+		/**
+		 * Remove a task by name. The storage for the name is kept, and reused if a task
+		 * with the same name is inserted again.
+		 * @returns true if the task existed
+		 */
+		bool Remove(const wchar_t *taskName);
+
+		/**
+		 * Get the name of the task in the given row
+		 */
+		const wchar_t *GetName(uint32_t row) const;
+
+		/**
+		 * Get the executable path of the task in the given row
+		 */
+		const wchar_t *GetExecutable(uint32_t row) const;
+
+		/**
+		 * Get the joined arguments of the task in the given row
+		 */
+		const wchar_t *GetArguments(uint32_t row) const;
+
+		/**
+		 * Get the start date of the task in the given row
+		 */
+		DateSpec GetStartDate(uint32_t row) const;
+
+		/**
+		 * Get the end date of the task in the given row
+		 */
+		DateSpec GetEndDate(uint32_t row) const;
+
+		/**
+		 * Get the daily start time of the task in the given row
+		 */
+		TimeSpec GetDailyStartTime(uint32_t row) const;
+
+		/**
+		 * Get the packed start date, end date and daily start time columns, e.g. for GetNextDailyRuns.
+		 * The columns are invalidated by any modification of the table.
+		 */
+		DailyScheduleColumns GetScheduleColumns() const;
+
+		/**
+		 * Get a hash of everything about the task in the given row other than its name, including its
+		 * settings, dependencies and the days in its blackout calendar. If two tasks with the same name
+		 * have the same hash, registering one in place of the other would not change anything.
+		 */
+		uint64_t GetContentHash(uint32_t row) const;
+
+		/**
+		 * Build a TaskDefinition for the task in the given row.
+		 * NOTE: Only the daily schedule is stored, the definition has default settings, no dependencies
+		 * and no blackout calendar.
+		 * Spread start times (see TaskDefinition::SetSpreadWindow) are stored already applied, so the
+		 * definition has no spread window but is registered with the same start time.
+		 */
+		TaskDefinition GetDefinition(uint32_t row) const;
+
+		/**
+		 * Get the total number of bytes allocated by the table
+		 */
+		size_t GetMemoryUsage() const;
+
+		/**
+		 * Get the number of bytes allocated per task, or 0 if the table is empty
+		 */
+		double GetBytesPerTask() const;
+	};
+
+	/**
+	 * The differences between two task tables, as found by DiffTaskTables
+	 */
+	struct TaskTableDiff
+	{
+		std::vector<uint32_t> inserted; // Rows of tasks in the next table that are not in the current table
+		std::vector<uint32_t> updated; // Rows of tasks in the next table whose contents have changed
+		std::vector<uint32_t> deleted; // Rows of tasks in the current table that are not in the next table
+	};
+
+	/**
+	 * Find the tasks that need to be registered or deleted to go from one table to another.
+	 * Tasks are matched by name ignoring case, and compared by content hash (see TaskTable::GetContentHash).
+	 * @param current The tasks as they are now
+	 * @param next The tasks as they should be
+	 * @param diff [out] The differences, existing contents are replaced.
+	 */
+	TASKSCHEDULER_EXPORT void DiffTaskTables(const TaskTable &current, const TaskTable &next, TaskTableDiff &diff);
+
+}
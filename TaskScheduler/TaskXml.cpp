@@ -0,0 +1,669 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+#include "TaskSchedulerSupport.h"
+
+namespace task_scheduler {
+
+	// How much is buffered before writing, and read at a time
+	static const size_t XML_CHUNK_SIZE = 64 * 1024;
+
+	static const char XML_FILE_HEADER[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<Tasks>\n";
+	static const char XML_FILE_FOOTER[] = "</Tasks>\n";
+
+	// Append text to XML, escaping the characters that can't appear in element content or attributes
+	static void AppendEscaped(std::wstring &dst, const wchar_t *str, size_t length)
+	{
+		for (size_t i = 0; i < length; i++) {
+			switch (str[i]) {
+			case L'&': dst += L"&amp;"; break;
+			case L'<': dst += L"&lt;"; break;
+			case L'>': dst += L"&gt;"; break;
+			case L'"': dst += L"&quot;"; break;
+			case L'\'': dst += L"&apos;"; break;
+			default: dst += str[i]; break;
+			}
+		}
+	}
+
+	static void AppendEscaped(std::wstring &dst, const std::wstring &str)
+	{
+		AppendEscaped(dst, str.c_str(), str.size());
+	}
+
+	// Append an element with text content, on a line of its own
+	static void AppendElement(std::wstring &dst, const wchar_t *indent, const wchar_t *name, const std::wstring &text)
+	{
+		dst += indent;
+		dst += L'<';
+		dst += name;
+		dst += L'>';
+		AppendEscaped(dst, text);
+		dst += L"</";
+		dst += name;
+		dst += L">\n";
+	}
+
+	static void AppendBoundaries(std::wstring &dst, const DateSpec &startDate, const TimeSpec &startTime,
+		const DateSpec &endDate)
+	{
+		wchar_t timespec[DATE_FORMAT_STRING_SIZE];
+		if (startDate.GetYear()) {
+			FormatDateString(timespec, DATE_FORMAT_STRING_SIZE, startDate, startTime);
+			AppendElement(dst, L"      ", L"StartBoundary", timespec);
+		}
+		if (endDate.GetYear()) {
+			FormatDateString(timespec, DATE_FORMAT_STRING_SIZE, endDate);
+			AppendElement(dst, L"      ", L"EndBoundary", timespec);
+		}
+	}
+
+	TASKSCHEDULER_EXPORT void FormatTaskXml(std::wstring &dst, const TaskDefinition &task)
+	{
+		dst += L"<Task version=\"1.2\" xmlns=\"http://schemas.microsoft.com/windows/2004/02/mit/task\">\n";
+		dst += L"  <RegistrationInfo>\n";
+		AppendElement(dst, L"    ", L"URI", L"\\" + task.GetName());
+		dst += L"  </RegistrationInfo>\n";
+
+		dst += L"  <Triggers>\n";
+		const std::vector<std::wstring> &dependencies = task.GetDependencies();
+		if (dependencies.empty()) {
+			DateSpec startDate;
+			TimeSpec startTime;
+			task.GetSpreadStart(startDate, startTime);
+			dst += L"    <CalendarTrigger>\n";
+			AppendBoundaries(dst, startDate, startTime, task.GetEndDate());
+			dst += L"      <ScheduleByDay>\n";
+			dst += L"        <DaysInterval>1</DaysInterval>\n";
+			dst += L"      </ScheduleByDay>\n";
+			dst += L"    </CalendarTrigger>\n";
+		}
+		for (size_t i = 0; i < dependencies.size(); i++) {
+			// The trigger id names the dependency, as it does when registered (see AddTaskCompletionTrigger)
+			std::wstring query;
+			BuildTaskCompletionQuery(query, dependencies[i]);
+			dst += L"    <EventTrigger id=\"After ";
+			AppendEscaped(dst, dependencies[i]);
+			dst += L"\">\n";
+			AppendBoundaries(dst, task.GetStartDate(), TimeSpec(), task.GetEndDate());
+			AppendElement(dst, L"      ", L"Subscription", query);
+			dst += L"    </EventTrigger>\n";
+		}
+		dst += L"  </Triggers>\n";
+
+		dst += L"  <Principals>\n";
+		dst += L"    <Principal id=\"Author\">\n";
+		dst += L"      <LogonType>InteractiveToken</LogonType>\n";
+		dst += L"    </Principal>\n";
+		dst += L"  </Principals>\n";
+
+		const TaskSettings &settings = task.GetSettings();
+		static const wchar_t *const POLICIES[] = { L"IgnoreNew", L"Queue", L"StopExisting", L"Parallel" };
+		dst += L"  <Settings>\n";
+		AppendElement(dst, L"    ", L"MultipleInstancesPolicy", POLICIES[settings.instancesPolicy]);
+		AppendElement(dst, L"    ", L"StartWhenAvailable", settings.startWhenAvailable ? L"true" : L"false");
+		if (settings.executionTimeLimit >= 0) {
+			std::wstring limit;
+			FormatDuration(limit, static_cast<uint32_t>(settings.executionTimeLimit));
+			AppendElement(dst, L"    ", L"ExecutionTimeLimit", limit);
+		}
+		if (settings.priority >= 0) {
+			AppendElement(dst, L"    ", L"Priority", std::to_wstring(settings.priority));
+		}
+		dst += L"  </Settings>\n";
+
+		dst += L"  <Actions Context=\"Author\">\n";
+		dst += L"    <Exec>\n";
+		AppendElement(dst, L"      ", L"Command", task.GetExecutable());
+		if (task.GetArguments()[0]) {
+			AppendElement(dst, L"      ", L"Arguments", task.GetArguments());
+		}
+		dst += L"    </Exec>\n";
+		dst += L"  </Actions>\n";
+		dst += L"</Task>\n";
+	}
+
+	// A range of characters within the XML being parsed
+	struct XmlRange
+	{
+		const wchar_t *begin;
+		const wchar_t *end;
+	};
+
+	static const wchar_t *FindText(const wchar_t *begin, const wchar_t *end, const wchar_t *text)
+	{
+		return std::search(begin, end, text, text + wcslen(text));
+	}
+
+	// Find the next element with the given name within a range, and move the range past it
+	// The tags of the subset that is parsed don't nest within themselves, so the first closing tag ends it
+	static bool FindElement(XmlRange &range, const wchar_t *name, XmlRange &attributes, XmlRange &content)
+	{
+		std::wstring open = std::wstring(L"<") + name;
+		size_t nameLength = open.size();
+		const wchar_t *start = range.begin;
+		for (;;) {
+			start = FindText(start, range.end, open.c_str());
+			if (start == range.end || start + nameLength == range.end) {
+				return false;
+			}
+			// Skip longer names that start with this one, e.g. <Tasks> when looking for <Task>
+			wchar_t next = start[nameLength];
+			if (next == L'>' || next == L'/' || iswspace(next)) {
+				break;
+			}
+			start += nameLength;
+		}
+
+		const wchar_t *tagEnd = std::find(start + nameLength, range.end, L'>');
+		if (tagEnd == range.end) {
+			return false;
+		}
+		attributes.begin = start + nameLength;
+		attributes.end = tagEnd;
+
+		// An empty element, e.g. <Arguments/>
+		if (tagEnd[-1] == L'/') {
+			attributes.end--;
+			content.begin = content.end = tagEnd;
+			range.begin = tagEnd + 1;
+			return true;
+		}
+
+		std::wstring close = std::wstring(L"</") + name + L">";
+		content.begin = tagEnd + 1;
+		content.end = FindText(content.begin, range.end, close.c_str());
+		if (content.end == range.end) {
+			return false;
+		}
+		range.begin = content.end + close.size();
+		return true;
+	}
+
+	// Parse a character reference without its & and ;, e.g. #38 or #x26, returning false if it isn't
+	// a valid character, i.e. a surrogate or beyond the last code point
+	static bool ParseCharacterReference(const std::wstring &entity, uint32_t &codePoint)
+	{
+		bool hex = entity.size() > 1 && (entity[1] == L'x' || entity[1] == L'X');
+		const wchar_t *digits = entity.c_str() + (hex ? 2 : 1);
+		wchar_t *end = NULL;
+		unsigned long value = iswxdigit(*digits) ? wcstoul(digits, &end, hex ? 16 : 10) : 0;
+		if (!end || *end || value == 0 || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) {
+			return false;
+		}
+		codePoint = (uint32_t)value;
+		return true;
+	}
+
+	// Test that every character reference in a range is a valid character
+	static bool CheckCharacterReferences(const XmlRange &range)
+	{
+		uint32_t codePoint;
+		for (const wchar_t *p = FindText(range.begin, range.end, L"&#"); p < range.end;
+			p = FindText(p + 1, range.end, L"&#")) {
+			const wchar_t *semicolon = std::find(p, range.end, L';');
+			if (semicolon == range.end || !ParseCharacterReference(std::wstring(p + 1, semicolon), codePoint)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Append the text of XML content, replacing entity and character references
+	static void AppendUnescaped(std::wstring &dst, const XmlRange &range)
+	{
+		uint32_t codePoint;
+		for (const wchar_t *p = range.begin; p < range.end; p++) {
+			const wchar_t *semicolon = *p == L'&' ? std::find(p, range.end, L';') : range.end;
+			if (semicolon == range.end) {
+				dst += *p;
+				continue;
+			}
+
+			std::wstring entity(p + 1, semicolon);
+			if (entity == L"amp") {
+				dst += L'&';
+			} else if (entity == L"lt") {
+				dst += L'<';
+			} else if (entity == L"gt") {
+				dst += L'>';
+			} else if (entity == L"quot") {
+				dst += L'"';
+			} else if (entity == L"apos") {
+				dst += L'\'';
+			} else if (entity.size() > 1 && entity[0] == L'#' && ParseCharacterReference(entity, codePoint)) {
+				// Code points beyond the basic multilingual plane take a surrogate pair
+				if (codePoint >= 0x10000) {
+					codePoint -= 0x10000;
+					dst += (wchar_t)(0xD800 + (codePoint >> 10));
+					dst += (wchar_t)(0xDC00 + (codePoint & 0x3FF));
+				} else {
+					dst += (wchar_t)codePoint;
+				}
+			} else {
+				dst.append(p, semicolon + 1);
+			}
+			p = semicolon;
+		}
+	}
+
+	// Get the text of a child element, returning false if there isn't one
+	static bool GetElementText(const XmlRange &parent, const wchar_t *name, std::wstring &text)
+	{
+		XmlRange range = parent, attributes, content;
+		if (!FindElement(range, name, attributes, content)) {
+			return false;
+		}
+		text.clear();
+		AppendUnescaped(text, content);
+		return true;
+	}
+
+	// Get the value of an attribute, returning false if there isn't one
+	static bool GetAttribute(const XmlRange &attributes, const wchar_t *name, std::wstring &value)
+	{
+		std::wstring prefix = std::wstring(name) + L"=\"";
+		const wchar_t *start = attributes.begin;
+		for (;;) {
+			start = FindText(start, attributes.end, prefix.c_str());
+			if (start == attributes.end) {
+				return false;
+			}
+			if (start == attributes.begin || iswspace(start[-1])) {
+				break;
+			}
+			start += prefix.size();
+		}
+
+		XmlRange range = { start + prefix.size(), attributes.end };
+		range.end = std::find(range.begin, attributes.end, L'"');
+		value.clear();
+		AppendUnescaped(value, range);
+		return true;
+	}
+
+	// Parse a boundary in the format YYYY-MM-DDTHH:MM:SS, possibly followed by a time zone
+	static bool ParseBoundary(const std::wstring &boundary, DateSpec &date, TimeSpec &time)
+	{
+		std::wstring dateStr = boundary.substr(0, 10);
+		std::replace(dateStr.begin(), dateStr.end(), L'-', L'/');
+		if (!ParseDateString(date, dateStr.c_str())) {
+			return false;
+		}
+		if (boundary.size() < 19 || !ParseTimeString(time, boundary.substr(11, 8).c_str())) {
+			time = TimeSpec();
+		}
+		return true;
+	}
+
+	// Parse an XML duration in days, hours, minutes and seconds, e.g. PT72H
+	static bool ParseDuration(const std::wstring &str, int32_t &seconds)
+	{
+		if (str.empty() || str[0] != L'P') {
+			return false;
+		}
+
+		uint64_t total = 0;
+		bool inTime = false;
+		for (size_t i = 1; i < str.size(); ) {
+			if (str[i] == L'T') {
+				inTime = true;
+				i++;
+				continue;
+			}
+
+			wchar_t *end = NULL;
+			unsigned long value = wcstoul(str.c_str() + i, &end, 10);
+			size_t unit = end - str.c_str();
+			if (unit == i || unit >= str.size()) {
+				return false;
+			}
+			switch (str[unit]) {
+			case L'D': total += value * 86400ull; break;
+			case L'H': total += value * 3600ull; break;
+			case L'M': total += inTime ? value * 60ull : 0; break;
+			case L'S': total += value; break;
+			default: return false;
+			}
+			// Months and years have no fixed length
+			if (str[unit] == L'M' && !inTime) {
+				return false;
+			}
+			i = unit + 1;
+		}
+
+		if (total > INT32_MAX) {
+			return false;
+		}
+		seconds = (int32_t)total;
+		return true;
+	}
+
+	// Get the name of a task from the content of its <Task> element, returning false if it has none
+	static bool GetTaskName(const XmlRange &taskContent, std::wstring &name)
+	{
+		// The name is the last part of the registration URI, e.g. \Folder\Name
+		XmlRange range = taskContent, section, sectionAttributes;
+		std::wstring uri;
+		if (!FindElement(range, L"RegistrationInfo", sectionAttributes, section) ||
+			!GetElementText(section, L"URI", uri)) {
+			return false;
+		}
+		size_t separator = uri.find_last_of(L'\\');
+		name = uri.substr(separator == std::wstring::npos ? 0 : separator + 1);
+		return !name.empty();
+	}
+
+	TASKSCHEDULER_EXPORT bool GetTaskXmlName(std::wstring &name, const wchar_t *xml, size_t length)
+	{
+		XmlRange document = { xml, xml + length }, attributes, taskContent;
+		return xml && FindElement(document, L"Task", attributes, taskContent) &&
+			CheckCharacterReferences(taskContent) && GetTaskName(taskContent, name);
+	}
+
+	TASKSCHEDULER_EXPORT bool ParseTaskXml(TaskDefinition &task, const wchar_t *xml, size_t length)
+	{
+		task = TaskDefinition();
+		XmlRange document = { xml, xml + length }, attributes, taskContent;
+		if (!xml || !FindElement(document, L"Task", attributes, taskContent) ||
+			!CheckCharacterReferences(taskContent)) {
+			return false;
+		}
+
+		XmlRange section, sectionAttributes, range;
+		std::wstring text;
+		if (GetTaskName(taskContent, text)) {
+			task.SetName(text.c_str());
+		}
+
+		range = taskContent;
+		if (FindElement(range, L"Triggers", sectionAttributes, section)) {
+			bool daily = false;
+			DateSpec date;
+			TimeSpec time;
+			XmlRange triggers = section, trigger, triggerAttributes;
+			while (FindElement(triggers, L"CalendarTrigger", triggerAttributes, trigger)) {
+				if (!daily && GetElementText(trigger, L"StartBoundary", text) && ParseBoundary(text, date, time)) {
+					task.SetStartDate(date);
+					task.SetDailyStartTime(time);
+				}
+				if (GetElementText(trigger, L"EndBoundary", text) && ParseBoundary(text, date, time)) {
+					task.SetEndDate(date);
+				}
+				daily = true;
+			}
+
+			triggers = section;
+			while (!daily && FindElement(triggers, L"EventTrigger", triggerAttributes, trigger)) {
+				std::wstring id;
+				if (!GetAttribute(triggerAttributes, L"id", id) || id.compare(0, 6, L"After ") != 0) {
+					continue;
+				}
+				task.AddDependency(id.c_str() + 6);
+				if (GetElementText(trigger, L"StartBoundary", text) && ParseBoundary(text, date, time)) {
+					task.SetStartDate(date);
+				}
+				if (GetElementText(trigger, L"EndBoundary", text) && ParseBoundary(text, date, time)) {
+					task.SetEndDate(date);
+				}
+			}
+		}
+
+		range = taskContent;
+		if (FindElement(range, L"Settings", sectionAttributes, section)) {
+			TaskSettings settings;
+			if (GetElementText(section, L"MultipleInstancesPolicy", text)) {
+				if (text == L"Queue") {
+					settings.instancesPolicy = INSTANCES_QUEUE;
+				} else if (text == L"StopExisting") {
+					settings.instancesPolicy = INSTANCES_STOP_EXISTING;
+				} else if (text == L"Parallel") {
+					settings.instancesPolicy = INSTANCES_PARALLEL;
+				}
+			}
+			if (GetElementText(section, L"StartWhenAvailable", text)) {
+				settings.startWhenAvailable = text == L"true" || text == L"1";
+			} else {
+				// The task service default
+				settings.startWhenAvailable = false;
+			}
+			int32_t limit;
+			if (GetElementText(section, L"ExecutionTimeLimit", text) && ParseDuration(text, limit)) {
+				settings.executionTimeLimit = limit;
+			}
+			if (GetElementText(section, L"Priority", text)) {
+				int32_t priority = (int32_t)wcstol(text.c_str(), NULL, 10);
+				if (priority >= TaskSettings::HIGHEST_PRIORITY && priority <= TaskSettings::LOWEST_PRIORITY) {
+					settings.priority = priority;
+				}
+			}
+			task.SetSettings(settings);
+		}
+
+		range = taskContent;
+		XmlRange exec;
+		if (!FindElement(range, L"Actions", sectionAttributes, section) ||
+			!FindElement(section, L"Exec", sectionAttributes, exec) || !GetElementText(exec, L"Command", text)) {
+			return false;
+		}
+		task.SetExecutable(text.c_str());
+		if (GetElementText(exec, L"Arguments", text)) {
+			task.SetArgumentString(text.c_str());
+		}
+		return true;
+	}
+
+	struct TaskXmlWriter::Impl
+	{
+		FILE *file;
+		std::string buffer;
+		std::string converted;
+		std::wstring xml;
+		bool failed;
+
+		Impl() : file(NULL), failed(false)
+		{
+		}
+
+		void Append(const char *str, size_t length)
+		{
+			buffer.append(str, length);
+			if (buffer.size() >= XML_CHUNK_SIZE) {
+				Flush();
+			}
+		}
+
+		void Flush()
+		{
+			if (!buffer.empty() && fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+				failed = true;
+			}
+			buffer.clear();
+		}
+	};
+
+	TaskXmlWriter::TaskXmlWriter() : impl(new Impl())
+	{
+	}
+
+	TaskXmlWriter::~TaskXmlWriter()
+	{
+		Close();
+		delete impl;
+	}
+
+	bool TaskXmlWriter::Open(const wchar_t *path)
+	{
+		if (impl->file || _wfopen_s(&impl->file, path, L"wb")) {
+			return false;
+		}
+
+		impl->failed = false;
+		impl->buffer.reserve(XML_CHUNK_SIZE * 2);
+		impl->Append(XML_FILE_HEADER, sizeof(XML_FILE_HEADER) - 1);
+		return true;
+	}
+
+	bool TaskXmlWriter::Write(const TaskDefinition &task)
+	{
+		impl->xml.clear();
+		FormatTaskXml(impl->xml, task);
+		return WriteXml(impl->xml.c_str(), impl->xml.size());
+	}
+
+	bool TaskXmlWriter::WriteXml(const wchar_t *taskXml, size_t length)
+	{
+		if (!impl->file || !taskXml) {
+			return false;
+		}
+
+		// Skip any XML declaration, and the whitespace around it
+		const wchar_t *end = taskXml + length;
+		const wchar_t *start = taskXml;
+		while (start < end && iswspace(*start)) {
+			start++;
+		}
+		if (end - start >= 5 && wcsncmp(start, L"<?xml", 5) == 0) {
+			start = FindText(start, end, L"?>");
+			start = start == end ? end : start + 2;
+			while (start < end && iswspace(*start)) {
+				start++;
+			}
+		}
+		while (end > start && iswspace(end[-1])) {
+			end--;
+		}
+
+		if (!WideToUtf8(impl->converted, start, end - start)) {
+			return false;
+		}
+		impl->converted += '\n';
+		impl->Append(impl->converted.data(), impl->converted.size());
+		return !impl->failed;
+	}
+
+	bool TaskXmlWriter::Close()
+	{
+		if (!impl->file) {
+			return false;
+		}
+
+		impl->Append(XML_FILE_FOOTER, sizeof(XML_FILE_FOOTER) - 1);
+		impl->Flush();
+		if (fclose(impl->file)) {
+			impl->failed = true;
+		}
+		impl->file = NULL;
+		return !impl->failed;
+	}
+
+	struct TaskXmlReader::Impl
+	{
+		FILE *file;
+		std::string buffer;
+		size_t position;
+		bool ended;
+		bool failed;
+
+		Impl() : file(NULL), position(0), ended(false), failed(false)
+		{
+		}
+
+		~Impl()
+		{
+			if (file) {
+				fclose(file);
+			}
+		}
+
+		// Find the start of the next <Task> element in the buffer, skipping e.g. <Tasks>
+		size_t FindTaskStart(size_t from) const
+		{
+			for (;;) {
+				size_t start = buffer.find("<Task", from);
+				if (start == std::string::npos || start + 5 >= buffer.size()) {
+					return std::string::npos;
+				}
+				char next = buffer[start + 5];
+				if (next == '>' || next == ' ' || next == '\t' || next == '\r' || next == '\n') {
+					return start;
+				}
+				from = start + 5;
+			}
+		}
+	};
+
+	TaskXmlReader::TaskXmlReader() : impl(new Impl())
+	{
+	}
+
+	TaskXmlReader::~TaskXmlReader()
+	{
+		delete impl;
+	}
+
+	bool TaskXmlReader::Open(const wchar_t *path)
+	{
+		if (impl->file || _wfopen_s(&impl->file, path, L"rb")) {
+			impl->failed = true;
+			return false;
+		}
+		return true;
+	}
+
+	bool TaskXmlReader::Next(std::wstring &taskXml)
+	{
+		static const char TASK_END[] = "</Task>";
+
+		if (!impl->file || impl->failed) {
+			return false;
+		}
+
+		for (;;) {
+			size_t start = impl->FindTaskStart(impl->position);
+			size_t end = start == std::string::npos ? std::string::npos : impl->buffer.find(TASK_END, start);
+			if (end != std::string::npos) {
+				end += sizeof(TASK_END) - 1;
+				impl->position = end;
+				if (!Utf8ToWide(taskXml, impl->buffer.substr(start, end - start).c_str())) {
+					fprintf(stderr, "Task XML is not valid UTF-8\n");
+					impl->failed = true;
+					return false;
+				}
+				return true;
+			}
+
+			if (impl->ended) {
+				if (start != std::string::npos) {
+					fprintf(stderr, "Task XML ends part way through a task\n");
+					impl->failed = true;
+				}
+				return false;
+			}
+
+			// Drop everything before the task being read (or the tail that could be the start of one),
+			// then read some more
+			size_t keep = start != std::string::npos ? start :
+				std::max<size_t>(impl->position, impl->buffer.size() > 5 ? impl->buffer.size() - 5 : 0);
+			impl->buffer.erase(0, keep);
+			impl->position = 0;
+
+			size_t size = impl->buffer.size();
+			impl->buffer.resize(size + XML_CHUNK_SIZE);
+			size_t read = fread(&impl->buffer[size], 1, XML_CHUNK_SIZE, impl->file);
+			impl->buffer.resize(size + read);
+			if (read < XML_CHUNK_SIZE) {
+				impl->ended = true;
+				if (ferror(impl->file)) {
+					impl->failed = true;
+					return false;
+				}
+			}
+		}
+	}
+
+	bool TaskXmlReader::Failed() const
+	{
+		return impl->failed;
+	}
+
+}
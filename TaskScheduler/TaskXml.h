@@ -0,0 +1,125 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * Append the Task Scheduler 2.0 XML of a task to a string, as one <Task> element (without an XML
+	 * declaration). Only the subset of the schema that this library registers is written: the name
+	 * (as the registration URI), a daily calendar trigger or an event trigger per dependency, an
+	 * interactive token principal, the settings and the exec action.
+	 * NOTE: The start time is written after spreading (see TaskDefinition::SetSpreadWindow), and
+	 * blackout calendars are not written, the trigger covers every day.
+	 * @param dst [out] The string to append to
+	 * @param task The task
+	 */
+	TASKSCHEDULER_EXPORT void FormatTaskXml(std::wstring &dst, const TaskDefinition &task);
+
+	/**
+	 * Parse the XML of a task, as written by FormatTaskXml or exported from the task service.
+	 * Only the subset that FormatTaskXml writes is read, anything else is skipped. If the task has
+	 * several daily triggers, the first start and the last end are used.
+	 * @param task [out] The task, any existing definition is replaced
+	 * @param xml The XML of one <Task> element
+	 * @param length The length of the XML in characters
+	 * @returns false if the XML has no <Task> element or no exec action, or has a character reference
+	 * that isn't a valid character, true otherwise
+	 */
+	TASKSCHEDULER_EXPORT bool ParseTaskXml(TaskDefinition &task, const wchar_t *xml, size_t length);
+
+	/**
+	 * Get the name of a task from its XML, i.e. the last part of its registration URI, without
+	 * parsing anything else. Unlike ParseTaskXml this works for tasks with any kind of action.
+	 * @param name [out] The task name
+	 * @param xml The XML of one <Task> element
+	 * @param length The length of the XML in characters
+	 * @returns false if the XML has no <Task> element, has an invalid character reference, or the task
+	 * has no name
+	 */
+	TASKSCHEDULER_EXPORT bool GetTaskXmlName(std::wstring &name, const wchar_t *xml, size_t length);
+
+	/**
+	 * Writes a file of task XML, as a <Tasks> element holding one <Task> element per task, in UTF-8.
+	 * Tasks are written through a small buffer as they are added, so any number of tasks can be
+	 * written without holding them all in memory.
+	 */
+	class TASKSCHEDULER_EXPORT TaskXmlWriter
+	{
+		struct Impl;
+		Impl *impl;
+
+	public:
+		TaskXmlWriter();
+
+		/**
+		 * Close the file, if it is still open
+		 */
+		~TaskXmlWriter();
+
+		TaskXmlWriter(const TaskXmlWriter &) = delete;
+		TaskXmlWriter &operator=(const TaskXmlWriter &) = delete;
+
+		/**
+		 * Create the file, replacing any existing file
+		 * @returns true if the file was created
+		 */
+		bool Open(const wchar_t *path);
+
+		/**
+		 * Write a task, see FormatTaskXml
+		 * @returns false if the file could not be written
+		 */
+		bool Write(const TaskDefinition &task);
+
+		/**
+		 * Write the XML of a task as it is, e.g. as exported from the task service. Any leading XML
+		 * declaration is skipped, as the file has its own.
+		 * @param taskXml The XML of one <Task> element
+		 * @param length The length of the XML in characters
+		 * @returns false if the file could not be written
+		 */
+		bool WriteXml(const wchar_t *taskXml, size_t length);
+
+		/**
+		 * Finish and close the file
+		 * @returns true if the whole file was written
+		 */
+		bool Close();
+	};
+
+	/**
+	 * Reads a file written by TaskXmlWriter one <Task> element at a time, so that memory use is
+	 * bounded by the largest task rather than the size of the file.
+	 */
+	class TASKSCHEDULER_EXPORT TaskXmlReader
+	{
+		struct Impl;
+		Impl *impl;
+
+	public:
+		TaskXmlReader();
+		~TaskXmlReader();
+
+		TaskXmlReader(const TaskXmlReader &) = delete;
+		TaskXmlReader &operator=(const TaskXmlReader &) = delete;
+
+		/**
+		 * Open a file for reading
+		 * @returns true if the file was opened
+		 */
+		bool Open(const wchar_t *path);
+
+		/**
+		 * Read the next task, e.g. to parse with ParseTaskXml, or register as it is
+		 * @param taskXml [out] The XML of the next <Task> element
+		 * @returns false at the end of the file, or if the file can't be read (see Failed)
+		 */
+		bool Next(std::wstring &taskXml);
+
+		/**
+		 * Test if reading stopped because the file couldn't be read or was truncated, rather than
+		 * because it ended
+		 */
+		bool Failed() const;
+	};
+
+}
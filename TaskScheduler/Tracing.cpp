@@ -0,0 +1,164 @@
+#include "stdafx.h"
+#include "TaskSchedulerAPI.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace task_scheduler {
+
+	// The most spans kept per thread between flushes, further spans are dropped
+	static const size_t MAX_SPANS_PER_THREAD = 1 << 20;
+
+	struct TraceEvent
+	{
+		const char *name;
+		int64_t start;
+		int64_t duration;
+	};
+
+	// The spans recorded by a single thread. The lock is only contended while flushing.
+	struct ThreadTrace
+	{
+		std::mutex lock;
+		uint32_t threadId;
+		std::vector<TraceEvent> events;
+		uint64_t dropped;
+
+		ThreadTrace() : threadId(GetCurrentThreadId()), dropped(0)
+		{
+		}
+	};
+
+	static std::atomic<bool> tracingEnabled(false);
+
+	// The buffers of every thread that has recorded a span, kept after the thread exits
+	static std::mutex allThreadsLock;
+	static std::vector<ThreadTrace *> allThreads;
+
+	static ThreadTrace &GetThreadTrace()
+	{
+		static thread_local ThreadTrace *trace = NULL;
+		if (!trace) {
+			trace = new ThreadTrace();
+			std::lock_guard<std::mutex> lock(allThreadsLock);
+			allThreads.push_back(trace);
+		}
+		return *trace;
+	}
+
+	void EnableTracing(bool enable)
+	{
+		tracingEnabled.store(enable, std::memory_order_relaxed);
+	}
+
+	bool IsTracingEnabled()
+	{
+		return tracingEnabled.load(std::memory_order_relaxed);
+	}
+
+	int64_t GetTraceTime()
+	{
+		static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+	}
+
+	void RecordTraceSpan(const char *name, int64_t start, int64_t end)
+	{
+		ThreadTrace &trace = GetThreadTrace();
+		std::lock_guard<std::mutex> lock(trace.lock);
+		if (trace.events.size() >= MAX_SPANS_PER_THREAD) {
+			trace.dropped++;
+			return;
+		}
+
+		TraceEvent event = { name, start, end - start };
+		trace.events.push_back(event);
+	}
+
+	// Append a string to JSON output, escaping it as necessary
+	static void AppendJsonString(std::string &dst, const char *str)
+	{
+		dst += '"';
+		for (const char *c = str; *c; c++) {
+			if (*c == '"' || *c == '\\') {
+				dst += '\\';
+				dst += *c;
+			} else if ((unsigned char)*c < 0x20) {
+				char escaped[8];
+				sprintf_s(escaped, sizeof(escaped), "\\u%04x", (unsigned)*c);
+				dst += escaped;
+			} else {
+				dst += *c;
+			}
+		}
+		dst += '"';
+	}
+
+	void FormatTrace(std::string &dst)
+	{
+		uint32_t processId = GetCurrentProcessId();
+		char line[128];
+		bool first = true;
+
+		dst = "{\"traceEvents\":[";
+
+		std::lock_guard<std::mutex> allLock(allThreadsLock);
+		for (size_t t = 0; t < allThreads.size(); t++) {
+			// Take the thread's spans, so that it can keep recording while they are formatted
+			ThreadTrace &trace = *allThreads[t];
+			std::vector<TraceEvent> events;
+			uint64_t dropped;
+			{
+				std::lock_guard<std::mutex> lock(trace.lock);
+				events.swap(trace.events);
+				dropped = trace.dropped;
+				trace.dropped = 0;
+			}
+
+			for (size_t e = 0; e < events.size(); e++) {
+				dst += first ? "\n" : ",\n";
+				first = false;
+
+				// A complete event, with times in microseconds
+				dst += "{\"name\":";
+				AppendJsonString(dst, events[e].name);
+				sprintf_s(line, sizeof(line), ",\"cat\":\"task_scheduler\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%u,\"tid\":%u}",
+					(long long)events[e].start, (long long)events[e].duration, processId, trace.threadId);
+				dst += line;
+			}
+
+			if (dropped) {
+				fprintf(stderr, "Dropped %llu trace spans on thread %u\n", (unsigned long long)dropped, trace.threadId);
+			}
+		}
+
+		dst += "\n]}\n";
+	}
+
+	bool WriteTraceFile(const wchar_t *path)
+	{
+		if (!path || !path[0]) {
+			return false;
+		}
+
+		std::string trace;
+		FormatTrace(trace);
+
+		HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			fprintf(stderr, "Could not create trace file %S: %x\n", path, GetLastError());
+			return false;
+		}
+
+		DWORD written = 0;
+		BOOL ok = WriteFile(file, trace.data(), (DWORD)trace.size(), &written, NULL);
+		CloseHandle(file);
+		if (!ok || written != trace.size()) {
+			fprintf(stderr, "Could not write trace file %S: %x\n", path, GetLastError());
+			return false;
+		}
+
+		return true;
+	}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+namespace task_scheduler {
+
+	/**
+	 * Turn recording of trace spans on or off. Tracing is off by default, and then a span costs
+	 * a call to IsTracingEnabled and a relaxed load.
+	 */
+	TASKSCHEDULER_EXPORT void EnableTracing(bool enable);
+
+	/**
+	 * Test if trace spans are being recorded
+	 */
+	TASKSCHEDULER_EXPORT bool IsTracingEnabled();
+
+	/**
+	 * Record a completed span on the calling thread. Each thread records into its own buffer.
+	 * @param name The name of the span, which must be a string literal (it is not copied)
+	 * @param start The start of the span, from GetTraceTime
+	 * @param end The end of the span, from GetTraceTime
+	 */
+	TASKSCHEDULER_EXPORT void RecordTraceSpan(const char *name, int64_t start, int64_t end);
+
+	/**
+	 * Get the current time for trace spans, in microseconds
+	 */
+	TASKSCHEDULER_EXPORT int64_t GetTraceTime();
+
+	/**
+	 * Format the recorded spans of all threads as Chrome trace-event JSON, which can be loaded
+	 * into chrome://tracing or Perfetto, and discard them.
+	 * @param dst [out] The string to write the JSON into, existing contents are replaced.
+	 */
+	TASKSCHEDULER_EXPORT void FormatTrace(std::string &dst);
+
+	/**
+	 * Write the recorded spans of all threads to a file as Chrome trace-event JSON, and discard them.
+	 * @returns true if the file was written
+	 */
+	TASKSCHEDULER_EXPORT bool WriteTraceFile(const wchar_t *path);
+
+	/**
+	 * Records a span from construction to destruction, if tracing is enabled
+	 */
+	class TraceSpan
+	{
+		const char *name;
+		int64_t start;
+
+	public:
+		explicit TraceSpan(const char *name) : name(name), start(IsTracingEnabled() ? GetTraceTime() : -1)
+		{
+		}
+
+		~TraceSpan()
+		{
+			if (start >= 0) {
+				RecordTraceSpan(name, start, GetTraceTime());
+			}
+		}
+
+		TraceSpan(const TraceSpan &) = delete;
+		TraceSpan &operator=(const TraceSpan &) = delete;
+	};
+
+}
+
+// Trace the rest of the enclosing scope, as a span with the given (literal) name
+#define TASKSCHEDULER_TRACE_CONCAT_(a, b) a##b
+#define TASKSCHEDULER_TRACE_CONCAT(a, b) TASKSCHEDULER_TRACE_CONCAT_(a, b)
+#define TASKSCHEDULER_TRACE_SPAN(name) \
+	task_scheduler::TraceSpan TASKSCHEDULER_TRACE_CONCAT(traceSpan, __LINE__)(name)
@@ -21,6 +21,7 @@
 #include <atlbase.h>
 #include <atlstr.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 
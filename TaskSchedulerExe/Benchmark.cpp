@@ -0,0 +1,359 @@
+// Benchmark.cpp : In-memory benchmarks for the TaskScheduler library.
+// These do not touch the task service, so they can be run anywhere.
+//
+#include "stdafx.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+
+using namespace task_scheduler;
+
+typedef std::chrono::steady_clock BenchmarkClock;
+
+static double ElapsedMs(BenchmarkClock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+}
+
+static void PrintResult(const char *name, double ms, uint32_t count)
+{
+	printf("%-12s %10.2f ms %10.1f ns/op\n", name, ms, count ? (ms * 1e6) / count : 0.0);
+}
+
+// Insert, look up and scan a table of near-identical tasks
+static int BenchmarkTaskTable(uint32_t count)
+{
+	static const wchar_t* ARGV[] = { L"--mode", L"nightly" };
+
+	TaskDefinition base;
+	base.SetExecutable(L"C:\\Program Files\\Service\\service.exe");
+	base.SetArguments(ARGV, 2);
+	base.SetStartDate(DateSpec(2017, 0, 0));
+
+	// Build the names up front, so that only the table is measured
+	std::vector<std::wstring> names(count);
+	for (uint32_t i = 0; i < count; i++) {
+		names[i] = L"service-task-" + std::to_wstring(i);
+	}
+
+	TaskTable table;
+	TaskDefinition task(base);
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	for (uint32_t i = 0; i < count; i++) {
+		task.SetName(names[i].c_str());
+		task.SetDailyStartTime(TimeSpec((uint8_t)(i % 24), (uint8_t)(i % 60), 0));
+		table.Insert(task);
+	}
+	PrintResult("insert", ElapsedMs(start), count);
+
+	uint32_t found = 0;
+	start = BenchmarkClock::now();
+	for (uint32_t i = 0; i < count; i++) {
+		if (table.Find(names[(i * 7919) % count].c_str()) != TaskTable::INVALID_ROW) {
+			found++;
+		}
+	}
+	PrintResult("lookup", ElapsedMs(start), count);
+
+	uint64_t total = 0;
+	start = BenchmarkClock::now();
+	DailyScheduleColumns columns = table.GetScheduleColumns();
+	for (size_t i = 0; i < columns.count; i++) {
+		total += columns.startSeconds[i];
+	}
+	PrintResult("scan", ElapsedMs(start), count);
+
+	printf("%u tasks, %u found, %.1f bytes per task (checksum %llu)\n", table.Size(), found,
+		table.GetBytesPerTask(), (unsigned long long)total);
+	return found == count ? 0 : 10;
+}
+
+// Diff two tables that differ by a single task, as when a manifest is reloaded after a one line change
+static int BenchmarkDiff(uint32_t count)
+{
+	static const wchar_t* ARGV[] = { L"--mode", L"nightly" };
+
+	TaskDefinition base;
+	base.SetExecutable(L"C:\\Program Files\\Service\\service.exe");
+	base.SetArguments(ARGV, 2);
+	base.SetStartDate(DateSpec(2017, 0, 0));
+
+	TaskTable current, next;
+	current.Reserve(count);
+	next.Reserve(count);
+	TaskDefinition task(base);
+	for (uint32_t i = 0; i < count; i++) {
+		task.SetName((L"service-task-" + std::to_wstring(i)).c_str());
+		task.SetDailyStartTime(TimeSpec((uint8_t)(i % 24), (uint8_t)(i % 60), 0));
+		current.Insert(task);
+		if (i == count / 2) {
+			task.SetDailyStartTime(TimeSpec(12, 34, 56));
+		}
+		next.Insert(task);
+	}
+
+	TaskTableDiff diff;
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	DiffTaskTables(current, next, diff);
+	PrintResult("diff", ElapsedMs(start), count);
+
+	printf("%u tasks, %u added, %u changed, %u removed\n", count, (unsigned)diff.inserted.size(),
+		(unsigned)diff.updated.size(), (unsigned)diff.deleted.size());
+	return diff.updated.size() == 1 ? 0 : 10;
+}
+
+// Compute the next run of many daily schedules, with the scalar and vectorized implementations
+static int BenchmarkNextRun(uint32_t count)
+{
+	static const int ROUNDS = 10;
+
+	// Spread start times across the day, and start and end dates across a few years
+	std::vector<int32_t> startDays(count), endDays(count), startSeconds(count);
+	int32_t firstDay = DateToDays(DateSpec(2017, 0, 0));
+	for (uint32_t i = 0; i < count; i++) {
+		startDays[i] = (i % 3) ? firstDay + (int32_t)(i % 1000) : NO_START_DAY;
+		endDays[i] = (i % 5) ? NO_END_DAY : firstDay + (int32_t)(i % 2000);
+		startSeconds[i] = (int32_t)((i * 7919) % SECONDS_PER_DAY);
+	}
+
+	DailyScheduleColumns columns;
+	columns.startDays = startDays.data();
+	columns.endDays = endDays.data();
+	columns.startSeconds = startSeconds.data();
+	columns.count = count;
+
+	std::vector<int64_t> scalarRuns(count), vectorRuns(count);
+	int64_t now = (int64_t)(firstDay + 500) * SECONDS_PER_DAY + 12 * 3600;
+
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	for (int round = 0; round < ROUNDS; round++) {
+		GetNextDailyRunsScalar(columns, now + round, scalarRuns.data());
+	}
+	PrintResult("scalar", ElapsedMs(start), count * ROUNDS);
+
+	start = BenchmarkClock::now();
+	for (int round = 0; round < ROUNDS; round++) {
+		GetNextDailyRuns(columns, now + round, vectorRuns.data());
+	}
+	PrintResult("vectorized", ElapsedMs(start), count * ROUNDS);
+
+	bool identical = scalarRuns == vectorRuns;
+	printf("%u schedules, results %s\n", count, identical ? "identical" : "DIFFER");
+	return identical ? 0 : 10;
+}
+
+// Show how the start times of tasks all registered for midnight are spread across a window
+static int BenchmarkSpread(uint32_t count)
+{
+	static const uint32_t WINDOW = 3600;
+	static const uint32_t BUCKETS = 60;
+
+	TaskDefinition task;
+	task.SetStartDate(DateSpec(2017, 0, 0));
+	task.SetDailyStartTime(TimeSpec(0, 0, 0));
+	task.SetSpreadWindow(WINDOW);
+
+	std::vector<uint32_t> perMinute(BUCKETS, 0);
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	for (uint32_t i = 0; i < count; i++) {
+		task.SetName((L"service-task-" + std::to_wstring(i)).c_str());
+
+		DateSpec startDate;
+		TimeSpec startTime;
+		task.GetSpreadStart(startDate, startTime);
+		perMinute[startTime.GetTotalSeconds() / 60]++;
+	}
+	PrintResult("spread", ElapsedMs(start), count);
+
+	// Without spreading, all count tasks would start in the first minute
+	uint32_t largest = *std::max_element(perMinute.begin(), perMinute.end());
+	for (uint32_t minute = 0; minute < BUCKETS; minute++) {
+		int width = largest ? (int)((uint64_t)perMinute[minute] * 50 / largest) : 0;
+		printf("00:%02u %8u %s\n", minute, perMinute[minute], std::string(width, '#').c_str());
+	}
+	printf("%u tasks, at most %u per minute instead of %u\n", count, largest, count);
+	return 0;
+}
+
+// Order a pipeline of tasks, each depending on up to two earlier tasks
+static int BenchmarkDependencies(uint32_t count)
+{
+	std::vector<TaskDefinition> tasks(count);
+	for (uint32_t i = 0; i < count; i++) {
+		tasks[i].SetName((L"pipeline-step-" + std::to_wstring(i)).c_str());
+		if (i > 0) {
+			tasks[i].AddDependency((L"pipeline-step-" + std::to_wstring(i - 1)).c_str());
+		}
+		if (i > 1) {
+			tasks[i].AddDependency((L"pipeline-step-" + std::to_wstring((i * 7919) % (i - 1))).c_str());
+		}
+	}
+
+	// Declare the tasks in reverse, so that every dependency has to wait
+	std::reverse(tasks.begin(), tasks.end());
+
+	std::vector<size_t> order;
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	bool sorted = SortByDependencies(tasks.data(), tasks.size(), order);
+	PrintResult("sort", ElapsedMs(start), count);
+
+	printf("%u tasks, %s\n", count, sorted ? "sorted" : "CYCLE");
+	return sorted ? 0 : 10;
+}
+
+// Write tasks as XML to a temporary file, then stream them back and parse each one
+static int BenchmarkXml(uint32_t count)
+{
+	static const wchar_t* ARGV[] = { L"--mode", L"nightly" };
+
+	wchar_t tempDir[MAX_PATH];
+	if (!GetTempPathW(_countof(tempDir), tempDir)) {
+		printf("Could not get the temporary directory\n");
+		return 10;
+	}
+	std::wstring path = std::wstring(tempDir) + L"TaskSchedulerBenchmark.xml";
+
+	TaskDefinition task;
+	task.SetExecutable(L"C:\\Program Files\\Service\\service.exe");
+	task.SetArguments(ARGV, 2);
+	task.SetStartDate(DateSpec(2017, 0, 0));
+
+	TaskXmlWriter writer;
+	if (!writer.Open(path.c_str())) {
+		printf("Could not create %S\n", path.c_str());
+		return 10;
+	}
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	for (uint32_t i = 0; i < count; i++) {
+		task.SetName((L"service-task-" + std::to_wstring(i)).c_str());
+		task.SetDailyStartTime(TimeSpec((uint8_t)(i % 24), (uint8_t)(i % 60), 0));
+		writer.Write(task);
+	}
+	bool written = writer.Close();
+	PrintResult("write", ElapsedMs(start), count);
+
+	uint32_t parsed = 0;
+	TaskXmlReader reader;
+	std::wstring xml;
+	TaskDefinition parsedTask;
+	start = BenchmarkClock::now();
+	if (reader.Open(path.c_str())) {
+		while (reader.Next(xml)) {
+			if (ParseTaskXml(parsedTask, xml.c_str(), xml.size())) {
+				parsed++;
+			}
+		}
+	}
+	PrintResult("read+parse", ElapsedMs(start), count);
+
+	WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+	GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &attributes);
+	uint64_t size = ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+	DeleteFileW(path.c_str());
+
+	bool succeeded = written && !reader.Failed() && parsed == count;
+	printf("%u tasks, %u parsed, %.0f bytes per task\n", count, parsed, (double)size / count);
+	return succeeded ? 0 : 10;
+}
+
+// Write lines of task output to a rotating log, one line at a time as from a chatty task that flushes
+// every line, then in pipe-sized blocks as the capture command reads them from a busy task
+static int BenchmarkLog(uint32_t count)
+{
+	static const uint64_t MAX_BYTES = 1024 * 1024;
+	static const uint32_t MAX_FILES = 4;
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	wchar_t tempDir[MAX_PATH];
+	if (!GetTempPathW(_countof(tempDir), tempDir)) {
+		printf("Could not get the temporary directory\n");
+		return 10;
+	}
+	std::wstring path = std::wstring(tempDir) + L"TaskSchedulerBenchmark.log";
+
+	// Build the output up front, so that only the log is measured
+	std::string output;
+	std::vector<size_t> lineEnds(count);
+	for (uint32_t i = 0; i < count; i++) {
+		output += "2017-11-01 02:30:00 service-task processed record " + std::to_string(i) +
+			" of the nightly batch without errors\n";
+		lineEnds[i] = output.size();
+	}
+
+	bool succeeded = true;
+	uint32_t rotations = 0;
+	const char *names[] = { "line", "block" };
+	for (int pass = 0; pass < 2; pass++) {
+		RotatingLog log;
+		if (!log.Open(path.c_str(), MAX_BYTES, MAX_FILES)) {
+			return 10;
+		}
+
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		if (pass == 0) {
+			size_t offset = 0;
+			for (uint32_t i = 0; i < count; i++) {
+				succeeded &= log.Write(output.data() + offset, lineEnds[i] - offset);
+				offset = lineEnds[i];
+			}
+		} else {
+			for (size_t offset = 0; offset < output.size(); offset += BLOCK_SIZE) {
+				succeeded &= log.Write(output.data() + offset, std::min<size_t>(BLOCK_SIZE, output.size() - offset));
+			}
+		}
+		log.Close();
+		double ms = ElapsedMs(start);
+		PrintResult(names[pass], ms, count);
+		printf("%-12s %10.1f MB/s\n", "", ms > 0 ? output.size() / (ms * 1000.0) : 0.0);
+		rotations += log.GetRotationCount();
+	}
+
+	DeleteFileW(path.c_str());
+	for (uint32_t i = 1; i < MAX_FILES; i++) {
+		DeleteFileW((path + L"." + std::to_wstring(i)).c_str());
+	}
+
+	printf("%u lines, %.0f bytes per line, %u rotations\n", count, (double)output.size() / count, rotations);
+	return succeeded ? 0 : 10;
+}
+
+int RunBenchmark(int argc, const wchar_t **argv)
+{
+	std::wstring name = argc > 2 ? argv[2] : L"";
+	uint32_t count = 1000000;
+	if (argc > 3) {
+		count = (uint32_t)_wtoi(argv[3]);
+	}
+	if (count == 0) {
+		printf("Invalid count\n");
+		return 1;
+	}
+
+	if (L"table" == name) {
+		return BenchmarkTaskTable(count);
+	}
+	if (L"diff" == name) {
+		return BenchmarkDiff(count);
+	}
+	if (L"nextrun" == name) {
+		return BenchmarkNextRun(count);
+	}
+	if (L"dependencies" == name) {
+		return BenchmarkDependencies(count);
+	}
+	if (L"spread" == name) {
+		return BenchmarkSpread(count);
+	}
+	if (L"xml" == name) {
+		return BenchmarkXml(count);
+	}
+	if (L"log" == name) {
+		return BenchmarkLog(count);
+	}
+
+	printf("Unknown benchmark: %S\n", name.c_str());
+	return 1;
+}
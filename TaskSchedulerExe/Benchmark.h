@@ -0,0 +1,4 @@
+#pragma once
+
+// Run one of the in-memory benchmarks, where argv[2] is the name of the benchmark
+int RunBenchmark(int argc, const wchar_t **argv);
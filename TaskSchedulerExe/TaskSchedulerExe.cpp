@@ -1,17 +1,36 @@
 // TaskSchedulerExe.cpp : Defines the entry point for the console application.
 //
 #include "stdafx.h"
+#include <algorithm>
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
 #include <ctime>
+#include <cwctype>
+
+#include "Benchmark.h"
 
 using namespace task_scheduler;
 static const wchar_t TEST_TASK_NAME[] = L"TEST_TASK";
 static const wchar_t TEST_EVENT_NAME[] = L"Global\\TASK_SCHEDULER_TEST_EVENT";
+static const wchar_t SNAPSHOT_NAME[] = L"Local\\TaskSchedulerSnapshot";
 
 static int ScheduleTask(int argc, const wchar_t **argv);
 static int DeleteTask(int argc, const wchar_t **argv);
+static int RunBatch(int argc, const wchar_t **argv);
+static int RunBulk(int argc, const wchar_t **argv);
+static int RunWatch(int argc, const wchar_t **argv);
+static int QueryTask(int argc, const wchar_t **argv);
 static int RunTest(int argc, const wchar_t **argv);
+static int RunProbe(int argc, const wchar_t **argv);
 static int SignalEvent();
+static int RunCapture(int argc, const wchar_t **argv);
+
+// Defaults for the log files of tasks scheduled with /LOG
+static const uint32_t DEFAULT_LOG_SIZE_MB = 10;
+static const uint32_t DEFAULT_LOG_FILES = 5;
 
 static void PrintUsage(int argc, const wchar_t **argv) 
 {
@@ -27,11 +46,72 @@ static void PrintUsage(int argc, const wchar_t **argv)
 	printf("\t\t/ST <date> - The start date in the format of: YYYY/MM/DD\n");
 	printf("\t\t/ET <date> - The optional end date in the format of: YYYY/MM/DD\n");
 	printf("\t\t/T <time> - The time to run each day in the format of: HH:MM:SS (24-hour clock)\n");
-	printf("\t\t/EXE <path> - The path to the executable\n\n");
+	printf("\t\t/SPREAD <seconds> - Start at a fixed offset, from a hash of the name, up to <seconds> after /T\n");
+	printf("\t\t/AFTER <name> - Instead of at a time each day, run each time task <name> succeeds\n");
+	printf("\t\t/BLACKOUT <calendar> - Don't run on the days in <calendar> (batch and watch only, see below)\n");
+	printf("\t\t/EXE <path> - The path to the executable\n");
+	printf("\t\t/TL <seconds> - The optional time limit for each run, 0 for none (default 72 hours)\n");
+	printf("\t\t/MI <policy> - What to do if the task is still running when next started:\n");
+	printf("\t\t\tignore (default), queue, stop or parallel\n");
+	printf("\t\t/PRI <priority> - The priority of each run, from 0 (highest) to 10 (lowest, default 7)\n");
+	printf("\t\t/LATE <policy> - What to do with a run that was missed, e.g. as the machine was off:\n");
+	printf("\t\t\trun (default) as soon as possible, or skip it\n");
+	printf("\t\t/LOG <file> - Capture the output of each run to <file>, rotated to <file>.1, <file>.2 etc when full\n");
+	printf("\t\t/LOGSIZE <MB> - The largest each log file may grow to (default %u)\n", DEFAULT_LOG_SIZE_MB);
+	printf("\t\t/LOGFILES <count> - The number of log files to keep, including the current one (default %u)\n\n",
+		DEFAULT_LOG_FILES);
 
 	printf("\tdelete <name> - Delete a scheduled task, where <name> is the name of the task\n\n");
 
+	printf("\tbulkdelete <pattern> - Delete every task whose name matches <pattern>, where * matches any\n");
+	printf("\t\tcharacters and ? any one character, e.g. service-* to delete by prefix\n\n");
+
+	printf("\tretime <pattern> <time> - Change the time every task matching <pattern> runs each day to <time>\n\n");
+
+	printf("\texport <file> [pattern] - Write the XML of every task (or every task matching <pattern>) to <file>\n\n");
+
+	printf("\timport <file> - Register every task in <file>, as written by export\n\n");
+
+	printf("\tbatch [file] - Run commands read one per line from <file> (or stdin) over a single connection\n");
+	printf("\t\tschedule <name> [options] - As above\n");
+	printf("\t\tdelete <name> - As above\n");
+	printf("\t\tblackout <calendar> <date>[-<date>]... - Add days to the named calendar, for /BLACKOUT\n");
+	printf("\t\tbulkdelete <pattern> - As above\n");
+	printf("\t\tretime <pattern> <time> - As above\n");
+	printf("\t\texport <file> [pattern] - As above\n");
+	printf("\t\timport <file> - As above\n");
+	printf("\t\tratelimit <prefix> <rate> <burst> [wait] - Limit the commands that follow on tasks whose names\n");
+	printf("\t\t\tstart with <prefix> (\"\" for all) to <rate> per second, in bursts of up to <burst>, waiting\n");
+	printf("\t\t\tup to <wait> milliseconds (default 0) before failing\n");
+	printf("\t\texists <name> - Test if a task exists\n");
+	printf("\t\tlist - List all tasks\n");
+	printf("\t\tmetrics <file> - Write the counters and latencies so far to <file>, in Prometheus text format\n");
+	printf("\t\ttrace start - Start recording what the commands that follow spend their time on\n");
+	printf("\t\ttrace stop <file> - Stop recording, and write a Chrome trace-event JSON file (see chrome://tracing)\n\n");
+
+	printf("\twatch <manifest> - Keep the scheduled tasks in sync with <manifest>, which has one schedule\n");
+	printf("\t\tor blackout command per line as for batch. Only tasks that were added, changed or removed are updated.\n");
+	printf("\t\tThe next run and last result of each task are published for the query command.\n\n");
+
+	printf("\tquery <name> - Show the next run and last result of a task, from a running watch command\n\n");
+
+	printf("\tcapture <file> <bytes> <count> <exe> [args...] - Run <exe>, capturing its output to <file>, rotated\n");
+	printf("\t\twhen it reaches <bytes> and keeping <count> files. Exits with the exit code of <exe>. Used by /LOG.\n");
+	printf("\t\tIf <file> is in use, e.g. by an overlapping run, <exe> still runs but its output is discarded.\n\n");
+
 	printf("\ttest - Test scheduling a task and verifying execution\n\n");
+
+	printf("\tprobe [rounds] - Schedule a task <rounds> times (default 10), and report how long registering\n");
+	printf("\t\ttakes and how late each run starts after its due time\n\n");
+
+	printf("\tbenchmark <name> [count] - Run an in-memory benchmark with <count> tasks (default 1000000)\n");
+	printf("\t\ttable - Insert, lookup and scan of a TaskTable\n");
+	printf("\t\tdiff - Diff of two TaskTables that differ by one task\n");
+	printf("\t\tnextrun - Next run computation, scalar and vectorized\n");
+	printf("\t\tdependencies - Dependency ordering of a pipeline of tasks\n");
+	printf("\t\tspread - Histogram of start times spread across an hour\n");
+	printf("\t\txml - Write <count> tasks as XML to a temporary file, then read and parse them back\n");
+	printf("\t\tlog - Write <count> lines of task output to a rotating log in a temporary directory\n\n");
 }
 
 int wmain(int argc, const wchar_t **argv) 
@@ -49,28 +129,91 @@ int wmain(int argc, const wchar_t **argv)
 	if (L"delete" == command) {
 		return DeleteTask(argc, argv);
 	}
+	if (L"batch" == command) {
+		return RunBatch(argc, argv);
+	}
+	if (L"bulkdelete" == command || L"retime" == command || L"export" == command || L"import" == command) {
+		return RunBulk(argc, argv);
+	}
+	if (L"watch" == command) {
+		return RunWatch(argc, argv);
+	}
+	if (L"query" == command) {
+		return QueryTask(argc, argv);
+	}
 	if (L"test" == command) {
 		return RunTest(argc, argv);
 	}
+	if (L"probe" == command) {
+		return RunProbe(argc, argv);
+	}
+	if (L"benchmark" == command) {
+		return RunBenchmark(argc, argv);
+	}
 	if (L"signal" == command) {
 		return SignalEvent();
 	}
+	if (L"capture" == command) {
+		return RunCapture(argc, argv);
+	}
 
 	PrintUsage(argc, argv);
 	return 1;
 }
 
-static int ScheduleTask(int argc, const wchar_t **argv) 
+// Named blackout calendars, as defined by blackout commands
+typedef std::unordered_map<std::wstring, std::shared_ptr<BlackoutCalendar>> BlackoutCalendars;
+
+struct ScheduleOptions
+{
+	std::wstring taskName;
+	std::wstring exePath;
+	DateSpec startDate, endDate;
+	TimeSpec timeOfDay;
+	uint32_t spreadWindow;
+	TaskSettings settings;
+	std::vector<std::wstring> after;
+	std::wstring blackout;
+	std::wstring logPath;
+	uint32_t logSizeMB;
+	uint32_t logFiles;
+
+	ScheduleOptions() : spreadWindow(0), logSizeMB(DEFAULT_LOG_SIZE_MB), logFiles(DEFAULT_LOG_FILES)
+	{
+	}
+};
+
+// Parse the name of an instances policy, as given to /MI
+static bool ParseInstancesPolicy(InstancesPolicy &policy, const std::wstring &str)
+{
+	if (L"ignore" == str) {
+		policy = INSTANCES_IGNORE_NEW;
+	} else if (L"queue" == str) {
+		policy = INSTANCES_QUEUE;
+	} else if (L"stop" == str) {
+		policy = INSTANCES_STOP_EXISTING;
+	} else if (L"parallel" == str) {
+		policy = INSTANCES_PARALLEL;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+// Parse the options to the schedule command, where argv[first] is the task name
+// Returns false and sets error if the options are invalid
+static bool ParseScheduleOptions(int argc, const wchar_t **argv, int first, ScheduleOptions &options, 
+	std::wstring &error)
 {
-	// Parse arguments
-	std::wstring taskName, startDateStr, endDateStr, timeStr, exePath;
+	std::wstring startDateStr, endDateStr, timeStr, spreadStr, timeLimitStr, policyStr, priorityStr, lateStr;
+	std::wstring logSizeStr, logFilesStr;
 
 	// Parse out arguments
-	if (argc > 2) {
-		taskName = argv[2];
+	if (argc > first) {
+		options.taskName = argv[first];
 	}
 
-	for (int i = 3; i < (argc-1); i+=2) {
+	for (int i = first + 1; i < (argc-1); i+=2) {
 		std::wstring arg = argv[i];
 		if (L"/ST" == arg) {
 			startDateStr = argv[i + 1];
@@ -79,52 +222,229 @@ static int ScheduleTask(int argc, const wchar_t **argv)
 		} else if (L"/T" == arg) {
 			timeStr = argv[i + 1];
 		} else if (L"/EXE" == arg) {
-			exePath = argv[i + 1];
+			options.exePath = argv[i + 1];
+		} else if (L"/SPREAD" == arg) {
+			spreadStr = argv[i + 1];
+		} else if (L"/AFTER" == arg) {
+			if (options.after.size() >= TaskDefinition::MAX_DEPENDENCIES) {
+				error = L"Only one /AFTER task can be given, as a task can't wait for several tasks to complete";
+				return false;
+			}
+			options.after.push_back(argv[i + 1]);
+		} else if (L"/BLACKOUT" == arg) {
+			options.blackout = argv[i + 1];
+		} else if (L"/TL" == arg) {
+			timeLimitStr = argv[i + 1];
+		} else if (L"/MI" == arg) {
+			policyStr = argv[i + 1];
+		} else if (L"/PRI" == arg) {
+			priorityStr = argv[i + 1];
+		} else if (L"/LATE" == arg) {
+			lateStr = argv[i + 1];
+		} else if (L"/LOG" == arg) {
+			options.logPath = argv[i + 1];
+		} else if (L"/LOGSIZE" == arg) {
+			logSizeStr = argv[i + 1];
+		} else if (L"/LOGFILES" == arg) {
+			logFilesStr = argv[i + 1];
 		} else {
-			PrintUsage(argc, argv);
-			printf("Unknown argument: %S\n", argv[i]);
-			return 1;
+			error = L"Unknown argument: " + arg;
+			return false;
 		}
 	}
 
 	// Now validate arguments
-	if (taskName.empty() || taskName[0] == L'/') {
-		PrintUsage(argc, argv);
-		printf("Invalid Task Name: %S\n", taskName.c_str());
-		return 1;
+	if (options.taskName.empty() || options.taskName[0] == L'/') {
+		error = L"Invalid Task Name: " + options.taskName;
+		return false;
 	}
 
-	if (exePath.empty()) {
-		PrintUsage(argc, argv);
-		printf("Executable path is required!\n");
-		return 1;
+	if (options.exePath.empty()) {
+		error = L"Executable path is required!";
+		return false;
 	}
 
-	DateSpec startDate, endDate;
-	TimeSpec timeOfDay;
+	if (!ParseDateString(options.startDate, startDateStr.c_str())) {
+		error = L"Invalid start date, expected YYYY/MM/DD";
+		return false;
+	}
+
+	// The time isn't needed for tasks that run after other tasks
+	if (!ParseTimeString(options.timeOfDay, timeStr.c_str()) && options.after.empty()) {
+		error = L"Invalid time, expected HH:MM:SS";
+		return false;
+	}
+
+	if (!spreadStr.empty()) {
+		wchar_t *end = NULL;
+		unsigned long spread = wcstoul(spreadStr.c_str(), &end, 10);
+		if (*end != L'\0' || spreadStr[0] == L'-' || spread > MAX_SPREAD_WINDOW) {
+			error = L"Invalid spread window, expected a number of seconds up to a day";
+			return false;
+		}
+		options.spreadWindow = static_cast<uint32_t>(spread);
+	}
+
+	if (!timeLimitStr.empty()) {
+		wchar_t *end = NULL;
+		unsigned long timeLimit = wcstoul(timeLimitStr.c_str(), &end, 10);
+		if (*end != L'\0' || timeLimitStr[0] == L'-' || timeLimit > INT32_MAX) {
+			error = L"Invalid time limit, expected a number of seconds";
+			return false;
+		}
+		options.settings.executionTimeLimit = static_cast<int32_t>(timeLimit);
+	}
 
-	if (!ParseDateString(startDate, startDateStr.c_str())) {
+	if (!policyStr.empty() && !ParseInstancesPolicy(options.settings.instancesPolicy, policyStr)) {
+		error = L"Invalid instances policy, expected ignore, queue, stop or parallel";
+		return false;
+	}
+
+	if (!priorityStr.empty()) {
+		wchar_t *end = NULL;
+		unsigned long priority = wcstoul(priorityStr.c_str(), &end, 10);
+		if (*end != L'\0' || priorityStr[0] == L'-' || priority > (unsigned long)TaskSettings::LOWEST_PRIORITY) {
+			error = L"Invalid priority, expected 0 (highest) to 10 (lowest)";
+			return false;
+		}
+		options.settings.priority = static_cast<int32_t>(priority);
+	}
+
+	if (L"run" == lateStr) {
+		options.settings.startWhenAvailable = true;
+	} else if (L"skip" == lateStr) {
+		options.settings.startWhenAvailable = false;
+	} else if (!lateStr.empty()) {
+		error = L"Invalid late policy, expected run or skip";
+		return false;
+	}
+
+	if (!logSizeStr.empty()) {
+		wchar_t *end = NULL;
+		unsigned long size = wcstoul(logSizeStr.c_str(), &end, 10);
+		if (*end != L'\0' || logSizeStr[0] == L'-' || size == 0 || size > 1024 * 1024) {
+			error = L"Invalid log size, expected a number of megabytes";
+			return false;
+		}
+		options.logSizeMB = static_cast<uint32_t>(size);
+	}
+
+	if (!logFilesStr.empty()) {
+		wchar_t *end = NULL;
+		unsigned long files = wcstoul(logFilesStr.c_str(), &end, 10);
+		if (*end != L'\0' || logFilesStr[0] == L'-' || files == 0 || files > 1000) {
+			error = L"Invalid log file count, expected 1 to 1000";
+			return false;
+		}
+		options.logFiles = static_cast<uint32_t>(files);
+	}
+
+	ParseDateString(options.endDate, endDateStr.c_str());
+	return true;
+}
+
+// Build the task definition described by the options to the schedule command
+// Returns false and sets error if the options refer to a calendar that hasn't been defined
+static bool ToTaskDefinition(const ScheduleOptions &options, const BlackoutCalendars &calendars, TaskDefinition &task,
+	std::wstring &error)
+{
+	if (!options.blackout.empty()) {
+		auto calendar = calendars.find(options.blackout);
+		if (calendar == calendars.end()) {
+			error = L"Unknown blackout calendar: " + options.blackout;
+			return false;
+		}
+		task.SetBlackoutCalendar(calendar->second);
+	}
+
+	task.SetName(options.taskName.c_str());
+	task.SetStartDate(options.startDate);
+	task.SetEndDate(options.endDate);
+	task.SetDailyStartTime(options.timeOfDay);
+	task.SetExecutable(options.exePath.c_str());
+	if (!options.logPath.empty()) {
+		// Run the executable through the capture command, which writes its output to the log
+		wchar_t exePath[MAX_PATH] = { 0 };
+		if (0 == GetModuleFileName(NULL, exePath, MAX_PATH)) {
+			error = L"Could not get executable name, for /LOG";
+			return false;
+		}
+		std::wstring logSize = std::to_wstring((uint64_t)options.logSizeMB * 1024 * 1024);
+		std::wstring logFiles = std::to_wstring(options.logFiles);
+		const wchar_t *captureArgv[] = { L"capture", options.logPath.c_str(), logSize.c_str(), logFiles.c_str(),
+			options.exePath.c_str() };
+		task.SetExecutable(exePath);
+		task.SetArguments(captureArgv, sizeof(captureArgv) / sizeof(captureArgv[0]));
+	}
+	task.SetSpreadWindow(options.spreadWindow);
+	task.SetSettings(options.settings);
+	for (size_t i = 0; i < options.after.size(); i++) {
+		task.AddDependency(options.after[i].c_str());
+	}
+	return true;
+}
+
+// Parse the options to the blackout command, where argv[first] is the calendar name, and add the
+// days to the calendar, creating it if necessary
+// Returns false and sets error if the options are invalid, in which case no days are added
+static bool ParseBlackout(int argc, const wchar_t **argv, int first, BlackoutCalendars &calendars,
+	std::wstring &error)
+{
+	if (argc < first + 2) {
+		error = L"Expected a calendar name and at least one date";
+		return false;
+	}
+
+	// Parse every range before adding any of them
+	std::vector<std::pair<DateSpec, DateSpec>> ranges;
+	for (int i = first + 1; i < argc; i++) {
+		std::wstring range(argv[i]);
+		size_t separator = range.find(L'-');
+		DateSpec firstDate, lastDate;
+		if (!ParseDateString(firstDate, range.substr(0, separator).c_str()) ||
+			(separator != std::wstring::npos && !ParseDateString(lastDate, range.substr(separator + 1).c_str()))) {
+			error = L"Invalid blackout days, expected YYYY/MM/DD or YYYY/MM/DD-YYYY/MM/DD: " + range;
+			return false;
+		}
+		ranges.push_back(std::make_pair(firstDate, separator == std::wstring::npos ? firstDate : lastDate));
+	}
+
+	std::shared_ptr<BlackoutCalendar> &calendar = calendars[argv[first]];
+	if (!calendar) {
+		calendar = std::make_shared<BlackoutCalendar>();
+	}
+	for (size_t i = 0; i < ranges.size(); i++) {
+		calendar->AddDays(ranges[i].first, ranges[i].second);
+	}
+	return true;
+}
+
+static int ScheduleTask(int argc, const wchar_t **argv) 
+{
+	ScheduleOptions options;
+	std::wstring error;
+	if (!ParseScheduleOptions(argc, argv, 2, options, error)) {
 		PrintUsage(argc, argv);
-		printf("Invalid start date, expected YYYY/MM/DD\n");
+		printf("%S\n", error.c_str());
 		return 1;
 	}
-
-	if (!ParseTimeString(timeOfDay, timeStr.c_str())) {
+	
+	// Calendars can only be defined in batch files and manifests
+	TaskDefinition task;
+	if (!ToTaskDefinition(options, BlackoutCalendars(), task, error)) {
 		PrintUsage(argc, argv);
-		printf("Invalid time, expected HH:MM:SS\n");
+		printf("%S\n", error.c_str());
 		return 1;
 	}
 
-	ParseDateString(endDate, endDateStr.c_str());
-	
-	ScheduleTaskResult result = ScheduleDailyExecutableTask(taskName.c_str(), 
-		startDate, endDate, timeOfDay, exePath.c_str(), NULL, 0);
+	TaskSchedulerSession session;
+	ScheduleTaskResult result = session.RegisterTask(task);
 	if (result == SCHEDULE_TASK_ERROR) {
 		printf("Unable to schedule task!\n");
 		return 10;
 	}
 
-	printf("The task %S has been created\n", taskName.c_str());
+	printf("The task %S has been created\n", options.taskName.c_str());
 	return 0;
 }
 
@@ -145,12 +465,347 @@ static int DeleteTask(int argc, const wchar_t **argv)
 	}
 }
 
-static void CurrentTimeToTimeSpec(DateSpec &date, TimeSpec &time, int32_t addSeconds = 0) 
+// Print the result line of a bulk command, followed by one line for each task it failed on
+static bool PrintBulkResult(const char *command, const wchar_t *pattern, bool succeeded, const BulkTaskResult &result)
+{
+	printf("%s %s %S %u of %u\n", succeeded ? "OK" : "ERROR", command, pattern, result.succeeded, result.matched);
+	for (size_t i = 0; i < result.failedNames.size(); i++) {
+		printf("%S %x\n", result.failedNames[i].c_str(), result.failedErrors[i]);
+	}
+	return succeeded;
+}
+
+// Write the XML of every task matching a pattern to a file, as the task service stores it
+static bool ExportTasks(TaskSchedulerSession &session, const wchar_t *path, const wchar_t *pattern)
+{
+	BulkTaskResult result;
+	std::vector<std::wstring> names;
+	TaskXmlWriter writer;
+	if (!session.ListTasks(names) || !writer.Open(path)) {
+		return PrintBulkResult("export", path, false, result);
+	}
+
+	std::wstring xml;
+	for (const std::wstring &name : names) {
+		if (!MatchTaskName(pattern, name.c_str())) {
+			continue;
+		}
+
+		result.matched++;
+		if (session.GetTaskXml(name.c_str(), xml) && writer.WriteXml(xml.c_str(), xml.size())) {
+			result.succeeded++;
+		} else {
+			result.failedNames.push_back(name);
+			result.failedErrors.push_back(E_FAIL);
+		}
+	}
+
+	bool closed = writer.Close();
+	return PrintBulkResult("export", path, closed && result.failedNames.empty(), result);
+}
+
+// Register every task in a file written by ExportTasks, replacing any existing tasks with the same names
+static bool ImportTasks(TaskSchedulerSession &session, const wchar_t *path)
+{
+	BulkTaskResult result;
+	TaskXmlReader reader;
+	if (!reader.Open(path)) {
+		return PrintBulkResult("import", path, false, result);
+	}
+
+	// The task is registered from its own XML as it is, whatever its actions, so only the name is read
+	std::wstring xml, name;
+	while (reader.Next(xml)) {
+		result.matched++;
+		if (!GetTaskXmlName(name, xml.c_str(), xml.size())) {
+			result.failedNames.push_back(L"<task " + std::to_wstring(result.matched) + L">");
+			result.failedErrors.push_back(E_INVALIDARG);
+			continue;
+		}
+
+		if (session.RegisterTaskXml(name.c_str(), xml.c_str()) == SCHEDULE_TASK_OK) {
+			result.succeeded++;
+		} else {
+			result.failedNames.push_back(name);
+			result.failedErrors.push_back(E_FAIL);
+		}
+	}
+
+	return PrintBulkResult("import", path, !reader.Failed() && result.failedNames.empty(), result);
+}
+
+// Run a single batch command against the session, printing one result line
+// Returns false if the command failed
+static bool RunBatchCommand(TaskSchedulerSession &session, BlackoutCalendars &calendars, int argc,
+	const wchar_t **argv)
+{
+	std::wstring command(argv[0]);
+	if (L"schedule" == command) {
+		ScheduleOptions options;
+		TaskDefinition task;
+		std::wstring error;
+		if (!ParseScheduleOptions(argc, argv, 1, options, error) ||
+			!ToTaskDefinition(options, calendars, task, error)) {
+			printf("ERROR schedule %S\n", error.c_str());
+			return false;
+		}
+
+		ScheduleTaskResult result = session.RegisterTask(task);
+		if (result != SCHEDULE_TASK_OK) {
+			printf("ERROR schedule %S%s\n", options.taskName.c_str(),
+				result == SCHEDULE_TASK_RATE_LIMITED ? " rate limited" : "");
+			return false;
+		}
+
+		printf("OK schedule %S\n", options.taskName.c_str());
+		return true;
+	}
+	if (L"delete" == command && argc == 2) {
+		bool rateLimited = false;
+		if (!session.DeleteTask(argv[1], &rateLimited)) {
+			printf("ERROR delete %S%s\n", argv[1], rateLimited ? " rate limited" : "");
+			return false;
+		}
+
+		printf("OK delete %S\n", argv[1]);
+		return true;
+	}
+	if (L"blackout" == command) {
+		std::wstring error;
+		if (!ParseBlackout(argc, argv, 1, calendars, error)) {
+			printf("ERROR blackout %S\n", error.c_str());
+			return false;
+		}
+
+		printf("OK blackout %S\n", argv[1]);
+		return true;
+	}
+	if (L"bulkdelete" == command && argc == 2) {
+		BulkTaskResult result;
+		bool succeeded = session.DeleteTasks(argv[1], result);
+		return PrintBulkResult("bulkdelete", argv[1], succeeded, result);
+	}
+	if (L"retime" == command && argc == 3) {
+		TimeSpec time;
+		if (!ParseTimeString(time, argv[2])) {
+			printf("ERROR retime Invalid time, expected HH:MM:SS\n");
+			return false;
+		}
+
+		BulkTaskResult result;
+		bool succeeded = session.RetimeTasks(argv[1], time, result);
+		return PrintBulkResult("retime", argv[1], succeeded, result);
+	}
+	if (L"export" == command && (argc == 2 || argc == 3)) {
+		return ExportTasks(session, argv[1], argc == 3 ? argv[2] : L"*");
+	}
+	if (L"import" == command && argc == 2) {
+		return ImportTasks(session, argv[1]);
+	}
+	if (L"ratelimit" == command && (argc == 4 || argc == 5)) {
+		wchar_t *rateEnd = NULL, *burstEnd = NULL, *waitEnd = NULL;
+		double callsPerSecond = wcstod(argv[2], &rateEnd);
+		unsigned long burst = wcstoul(argv[3], &burstEnd, 10);
+		unsigned long maxWaitMs = argc == 5 ? wcstoul(argv[4], &waitEnd, 10) : 0;
+		if (rateEnd == argv[2] || *rateEnd != L'\0' || !(callsPerSecond >= 0 && callsPerSecond <= 1e6) ||
+			burstEnd == argv[3] || *burstEnd != L'\0' || argv[3][0] == L'-' || burst < 1 || burst > UINT32_MAX ||
+			(argc == 5 && (waitEnd == argv[4] || *waitEnd != L'\0' || argv[4][0] == L'-' || maxWaitMs > UINT32_MAX))) {
+			printf("ERROR ratelimit Invalid rate, burst or wait\n");
+			return false;
+		}
+
+		// Limits apply to the commands that follow them
+		if (!session.GetRateLimiter()) {
+			session.SetRateLimiter(std::make_shared<RateLimiter>());
+		}
+		session.GetRateLimiter()->SetLimit(argv[1], callsPerSecond, (uint32_t)burst, (uint32_t)maxWaitMs);
+		printf("OK ratelimit %S\n", argv[1]);
+		return true;
+	}
+	if (L"exists" == command && argc == 2) {
+		printf("OK exists %S %s\n", argv[1], session.TaskExists(argv[1]) ? "true" : "false");
+		return true;
+	}
+	if (L"list" == command && argc == 1) {
+		std::vector<std::wstring> names;
+		if (!session.ListTasks(names)) {
+			printf("ERROR list\n");
+			return false;
+		}
+
+		printf("OK list %u\n", (unsigned)names.size());
+		for (const std::wstring &name : names) {
+			printf("%S\n", name.c_str());
+		}
+		return true;
+	}
+	if (L"metrics" == command && argc == 2) {
+		if (!WriteMetricsFile(argv[1])) {
+			printf("ERROR metrics %S\n", argv[1]);
+			return false;
+		}
+
+		printf("OK metrics %S\n", argv[1]);
+		return true;
+	}
+	if (L"trace" == command && argc == 2 && std::wstring(L"start") == argv[1]) {
+		EnableTracing(true);
+		printf("OK trace start\n");
+		return true;
+	}
+	if (L"trace" == command && argc == 3 && std::wstring(L"stop") == argv[1]) {
+		EnableTracing(false);
+		if (!WriteTraceFile(argv[2])) {
+			printf("ERROR trace stop %S\n", argv[2]);
+			return false;
+		}
+
+		printf("OK trace stop %S\n", argv[2]);
+		return true;
+	}
+
+	printf("ERROR Unknown command: %S\n", argv[0]);
+	return false;
+}
+
+// Strip the line ending and leading whitespace from a line read from a batch or manifest file
+// Returns NULL if the line should be skipped, i.e. it is blank or a comment
+static const wchar_t *TrimLine(wchar_t *line)
+{
+	size_t len = wcslen(line);
+	while (len > 0 && iswspace(line[len - 1])) {
+		line[--len] = 0;
+	}
+	const wchar_t *start = line + wcsspn(line, L" \t");
+	if (!*start || *start == L'#') {
+		return NULL;
+	}
+	return start;
+}
+
+static int RunBatch(int argc, const wchar_t **argv)
+{
+	FILE *input = stdin;
+	if (argc > 2) {
+		errno_t err = _wfopen_s(&input, argv[2], L"r, ccs=UTF-8");
+		if (err) {
+			printf("Could not open %S for reading\n", argv[2]);
+			return 1;
+		}
+	}
+
+	// Connect once, and run every command over the same session
+	TaskSchedulerSession session;
+	if (!session.IsConnected()) {
+		printf("Could not connect to the task scheduler\n");
+		if (input != stdin) {
+			fclose(input);
+		}
+		return 10;
+	}
+
+	// Calendars apply to the schedule commands that follow them
+	BlackoutCalendars calendars;
+	int failures = 0;
+	wchar_t line[4096];
+	while (fgetws(line, _countof(line), input)) {
+		// A line that fills the buffer without a newline is too long, rather than two commands
+		size_t length = wcslen(line);
+		if (length > 0 && line[length - 1] != L'\n' && !feof(input)) {
+			while (fgetws(line, _countof(line), input) && line[wcslen(line) - 1] != L'\n') {
+			}
+			printf("ERROR Command is longer than %u characters\n", (unsigned)(_countof(line) - 2));
+			fflush(stdout);
+			failures++;
+			continue;
+		}
+
+		const wchar_t *start = TrimLine(line);
+		if (!start) {
+			continue;
+		}
+
+		// Split the line using the same quoting rules as the command line
+		int lineArgc = 0;
+		LPWSTR *lineArgv = CommandLineToArgvW(start, &lineArgc);
+		if (!lineArgv) {
+			printf("ERROR Could not parse command\n");
+			fflush(stdout);
+			failures++;
+			continue;
+		}
+
+		if (!RunBatchCommand(session, calendars, lineArgc, const_cast<const wchar_t **>(lineArgv))) {
+			failures++;
+		}
+		LocalFree(lineArgv);
+
+		// Flush each result, so that callers can pipeline requests
+		fflush(stdout);
+	}
+
+	if (input != stdin) {
+		fclose(input);
+	}
+
+	return failures ? 10 : 0;
+}
+
+// Run a bulk, export or import command from the command line, as a batch of one
+static int RunBulk(int argc, const wchar_t **argv)
+{
+	TaskSchedulerSession session;
+	if (!session.IsConnected()) {
+		printf("Could not connect to the task scheduler\n");
+		return 10;
+	}
+
+	BlackoutCalendars calendars;
+	return RunBatchCommand(session, calendars, argc - 1, argv + 1) ? 0 : 10;
+}
+
+static int QueryTask(int argc, const wchar_t **argv)
+{
+	if (argc < 3) {
+		PrintUsage(argc, argv);
+		return 1;
+	}
+
+	TaskSnapshotReader snapshot;
+	if (!snapshot.Open(SNAPSHOT_NAME)) {
+		printf("No snapshot was found, is the watch command running?\n");
+		return 10;
+	}
+
+	TaskSnapshotEntry entry;
+	if (!snapshot.Find(argv[2], entry)) {
+		if (snapshot.TimedOut()) {
+			printf("The snapshot is being written and did not finish, was the watch command stopped?\n");
+			return 10;
+		}
+		printf("Task %S is not in the snapshot of %u tasks\n", argv[2], snapshot.Size());
+		return 10;
+	}
+
+	if (entry.nextRun == NO_NEXT_RUN) {
+		printf("Next run: none\n");
+	} else {
+		uint32_t seconds = (uint32_t)(entry.nextRun % SECONDS_PER_DAY);
+		wchar_t nextRun[DATE_FORMAT_STRING_SIZE];
+		FormatDateString(nextRun, _countof(nextRun), DaysToDate((int32_t)(entry.nextRun / SECONDS_PER_DAY)),
+			TimeSpec((uint8_t)(seconds / 3600), (uint8_t)(seconds / 60 % 60), (uint8_t)(seconds % 60)));
+		printf("Next run: %S\n", nextRun);
+	}
+	if (entry.lastResult == SCHED_S_TASK_HAS_NOT_RUN) {
+		printf("Last result: not run\n");
+	} else {
+		printf("Last result: %d\n", entry.lastResult);
+	}
+	return 0;
+}
+
+static void TimeToTimeSpec(time_t currentTime, DateSpec &date, TimeSpec &time)
 {
-	// Get current time (adjusting as specified)
-	time_t currentTime = ::time(NULL);
-	currentTime += addSeconds;
-	
 	struct tm newtime;
 	errno_t err = localtime_s(&newtime, &currentTime);
 	if (err) {
@@ -166,6 +821,365 @@ static void CurrentTimeToTimeSpec(DateSpec &date, TimeSpec &time, int32_t addSec
 	time = TimeSpec(newtime.tm_hour, newtime.tm_min, newtime.tm_sec);
 }
 
+static void CurrentTimeToTimeSpec(DateSpec &date, TimeSpec &time, int32_t addSeconds = 0) 
+{
+	// Get current time (adjusting as specified)
+	TimeToTimeSpec(::time(NULL) + addSeconds, date, time);
+}
+
+// Convert a time to local seconds since 1970-01-01, as used for next run times
+static int64_t TimeToLocalSeconds(time_t currentTime)
+{
+	DateSpec date;
+	TimeSpec time;
+	TimeToTimeSpec(currentTime, date, time);
+	return (int64_t)DateToDays(date) * SECONDS_PER_DAY + time.GetTotalSeconds();
+}
+
+// Read a manifest of schedule commands into a table, along with the definition of each row of the table
+// Returns false if the manifest can't be read, or any line is invalid
+static bool LoadManifest(const wchar_t *path, TaskTable &table, std::vector<TaskDefinition> &definitions)
+{
+	FILE *input = NULL;
+	if (_wfopen_s(&input, path, L"r, ccs=UTF-8")) {
+		printf("ERROR Could not open %S for reading\n", path);
+		return false;
+	}
+
+	// Calendars are built afresh on every load, so that tasks are only updated if their calendar changed
+	BlackoutCalendars calendars;
+	bool valid = true;
+	int lineNumber = 0;
+	wchar_t line[4096];
+	while (valid && fgetws(line, _countof(line), input)) {
+		lineNumber++;
+		const wchar_t *start = TrimLine(line);
+		if (!start) {
+			continue;
+		}
+
+		int lineArgc = 0;
+		LPWSTR *lineArgv = CommandLineToArgvW(start, &lineArgc);
+		if (!lineArgv) {
+			printf("ERROR %S(%d): Could not parse line\n", path, lineNumber);
+			valid = false;
+			break;
+		}
+
+		ScheduleOptions options;
+		TaskDefinition task;
+		std::wstring error;
+		if (lineArgc >= 1 && std::wstring(L"blackout") == lineArgv[0]) {
+			if (!ParseBlackout(lineArgc, const_cast<const wchar_t **>(lineArgv), 1, calendars, error)) {
+				printf("ERROR %S(%d): %S\n", path, lineNumber, error.c_str());
+				valid = false;
+			}
+		} else if (lineArgc < 1 || std::wstring(L"schedule") != lineArgv[0]) {
+			printf("ERROR %S(%d): Expected a schedule or blackout command\n", path, lineNumber);
+			valid = false;
+		} else if (!ParseScheduleOptions(lineArgc, const_cast<const wchar_t **>(lineArgv), 1, options, error) ||
+			!ToTaskDefinition(options, calendars, task, error)) {
+			printf("ERROR %S(%d): %S\n", path, lineNumber, error.c_str());
+			valid = false;
+		} else {
+			// Later lines for the same task replace earlier ones
+			uint32_t row = table.Insert(task);
+			if (row == definitions.size()) {
+				definitions.push_back(task);
+			} else {
+				definitions[row] = task;
+			}
+		}
+		LocalFree(lineArgv);
+	}
+
+	fclose(input);
+	return valid;
+}
+
+// The tasks registered by the watch command, along with what the table doesn't store about them
+// Task names ignore case, so sets and maps of tasks are keyed by the lower case name
+static std::wstring TaskNameKey(const std::wstring &name)
+{
+	std::wstring key(name);
+	std::transform(key.begin(), key.end(), key.begin(), [](wchar_t c) { return (wchar_t)towlower(c); });
+	return key;
+}
+
+struct LiveTasks
+{
+	TaskTable table;
+	// The names of the tasks that run after other tasks rather than daily (see TaskNameKey)
+	std::unordered_set<std::wstring> dependent;
+	// The blackout calendar of each task that has one (see TaskNameKey)
+	std::unordered_map<std::wstring, std::shared_ptr<const BlackoutCalendar>> calendars;
+};
+
+// Bring the registered tasks in line with the manifest, where live holds the tasks registered so far
+// Returns false if the manifest is invalid, in which case nothing is changed
+static bool SyncManifest(TaskSchedulerSession &session, const wchar_t *path, LiveTasks &live)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	TaskTable next;
+	std::vector<TaskDefinition> definitions;
+	if (!LoadManifest(path, next, definitions)) {
+		printf("ERROR watch %S is invalid, no tasks were changed\n", path);
+		return false;
+	}
+
+	TaskTableDiff diff;
+	DiffTaskTables(live.table, next, diff);
+
+	int failures = 0;
+
+	// Delete before registering, so that a delete can never remove a task that was just registered.
+	// Copy the names first, as removing rows from the table moves other rows.
+	std::vector<std::wstring> deleted;
+	for (uint32_t row : diff.deleted) {
+		deleted.push_back(live.table.GetName(row));
+	}
+	for (const std::wstring &name : deleted) {
+		if (session.DeleteTask(name.c_str()) || !session.TaskExists(name.c_str())) {
+			live.table.Remove(name.c_str());
+			live.dependent.erase(TaskNameKey(name));
+			live.calendars.erase(TaskNameKey(name));
+		} else {
+			printf("ERROR delete %S\n", name.c_str());
+			failures++;
+		}
+	}
+
+	// Register the new and changed tasks together, so that copies can share a definition
+	std::vector<TaskDefinition> changed;
+	changed.reserve(diff.inserted.size() + diff.updated.size());
+	for (uint32_t row : diff.inserted) {
+		changed.push_back(definitions[row]);
+	}
+	for (uint32_t row : diff.updated) {
+		changed.push_back(definitions[row]);
+	}
+
+	std::vector<ScheduleTaskResult> results(changed.size(), SCHEDULE_TASK_ERROR);
+	if (!changed.empty()) {
+		session.RegisterTasks(changed.data(), changed.size(), results.data());
+	}
+	for (size_t i = 0; i < changed.size(); i++) {
+		if (results[i] == SCHEDULE_TASK_OK) {
+			std::wstring name = TaskNameKey(changed[i].GetName());
+			live.table.Insert(changed[i]);
+			if (changed[i].GetDependencies().empty()) {
+				live.dependent.erase(name);
+			} else {
+				live.dependent.insert(name);
+			}
+			if (changed[i].GetBlackoutCalendar()) {
+				live.calendars[name] = changed[i].GetBlackoutCalendar();
+			} else {
+				live.calendars.erase(name);
+			}
+		} else {
+			printf("ERROR schedule %S\n", changed[i].GetName().c_str());
+			failures++;
+		}
+	}
+
+	printf("OK watch %u added, %u changed, %u removed, %d failed, %u tasks in %.1f ms\n",
+		(unsigned)diff.inserted.size(), (unsigned)diff.updated.size(), (unsigned)diff.deleted.size(), failures,
+		live.table.Size(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	fflush(stdout);
+	return true;
+}
+
+// Publish the next run and last result of each live task, for the query command
+// Get the next run of each row of the live tasks at or after a time, or NO_NEXT_RUN for tasks that
+// run after other tasks
+static void GetNextRuns(const LiveTasks &live, int64_t now, std::vector<int64_t> &nextRuns)
+{
+	const TaskTable &table = live.table;
+	nextRuns.resize(table.Size());
+	DailyScheduleColumns columns = table.GetScheduleColumns();
+	GetNextDailyRuns(columns, now, nextRuns.data());
+	if (!live.calendars.empty()) {
+		std::vector<const BlackoutCalendar *> calendars(table.Size());
+		for (const auto &calendar : live.calendars) {
+			uint32_t row = table.Find(calendar.first.c_str());
+			if (row != TaskTable::INVALID_ROW) {
+				calendars[row] = calendar.second.get();
+			}
+		}
+		SkipBlackoutDays(columns, calendars.data(), nextRuns.data());
+	}
+	for (uint32_t row = 0; row < table.Size(); row++) {
+		if (live.dependent.count(TaskNameKey(table.GetName(row)))) {
+			nextRuns[row] = NO_NEXT_RUN;
+		}
+	}
+}
+
+static void PublishSnapshot(TaskSchedulerSession &session, const LiveTasks &live, TaskSnapshotWriter &snapshot)
+{
+	const TaskTable &table = live.table;
+	std::vector<int64_t> nextRuns;
+	GetNextRuns(live, TimeToLocalSeconds(::time(NULL)), nextRuns);
+
+	// Tasks that haven't been registered (or run) yet are reported as not having run
+	std::vector<std::wstring> names;
+	std::vector<int32_t> lastResults;
+	session.ListTasks(names, lastResults);
+	std::unordered_map<std::wstring, int32_t> results;
+	for (size_t i = 0; i < lastResults.size(); i++) {
+		results[TaskNameKey(names[i])] = lastResults[i];
+	}
+
+	std::vector<TaskSnapshotEntry> entries(table.Size());
+	for (uint32_t row = 0; row < table.Size(); row++) {
+		entries[row].nextRun = nextRuns[row];
+		auto result = results.find(TaskNameKey(table.GetName(row)));
+		entries[row].lastResult = result == results.end() ? SCHED_S_TASK_HAS_NOT_RUN : result->second;
+	}
+	snapshot.Publish(table, entries.data());
+}
+
+// Get the last write time and size of a file, to tell if it has changed
+static bool GetFileVersion(const wchar_t *path, FILETIME &lastWrite, uint64_t &size)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExW(path, GetFileExInfoStandard, &data)) {
+		return false;
+	}
+	lastWrite = data.ftLastWriteTime;
+	size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	return true;
+}
+
+// Report a change of the wall clock, or a suspend, between two readings, along with how many tasks
+// were due in the time that was skipped or repeated
+// Returns true if there was one, i.e. next run times computed before it are now wrong
+static bool CheckClockJump(const LiveTasks &live, const ClockReading &last, const ClockReading &now)
+{
+	int64_t stepped, suspended, fromMs, toMs;
+	if (!ClassifyClockJump(last, now, stepped, suspended, fromMs, toMs)) {
+		return false;
+	}
+
+	if (suspended >= CLOCK_JUMP_TOLERANCE_MS) {
+		printf("Resumed after %lld seconds suspended\n", suspended / 1000);
+	}
+	if (stepped <= -CLOCK_JUMP_TOLERANCE_MS || stepped >= CLOCK_JUMP_TOLERANCE_MS) {
+		printf("The clock was changed by %+lld seconds\n", stepped / 1000);
+	}
+
+	// Only the tasks whose next run fell in the interval the process didn't see running are affected
+	int64_t expected = TimeToLocalSeconds((time_t)(fromMs / 1000));
+	int64_t actual = TimeToLocalSeconds((time_t)(toMs / 1000));
+	int64_t from = expected < actual ? expected : actual;
+	int64_t to = expected < actual ? actual : expected;
+	std::vector<int64_t> nextRuns;
+	GetNextRuns(live, from, nextRuns);
+	uint32_t due = 0;
+	for (int64_t nextRun : nextRuns) {
+		if (nextRun != NO_NEXT_RUN && nextRun < to) {
+			due++;
+		}
+	}
+	if (due) {
+		printf("%u tasks were due in the %s interval, the task service starts those that run when available\n",
+			due, expected < actual ? "skipped" : "repeated");
+	}
+	return true;
+}
+
+static int RunWatch(int argc, const wchar_t **argv)
+{
+	// How long to wait for writes to the manifest to settle, before reading it
+	static const DWORD SETTLE_MS = 100;
+	// How often to republish the snapshot when the manifest hasn't changed, as runs finish and times pass
+	static const DWORD SNAPSHOT_MS = 60 * 1000;
+	// The size of the snapshot's shared memory, enough for about 100,000 tasks with short names
+	static const uint32_t SNAPSHOT_CAPACITY = 16 * 1024 * 1024;
+
+	if (argc < 3) {
+		PrintUsage(argc, argv);
+		return 1;
+	}
+	const wchar_t *path = argv[2];
+
+	// Changes are watched for on the directory, as that is what change notifications support
+	std::wstring directory(path);
+	size_t separator = directory.find_last_of(L"\\/");
+	directory = separator == std::wstring::npos ? L"." : directory.substr(0, separator + 1);
+
+	HANDLE change = FindFirstChangeNotificationW(directory.c_str(), FALSE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE);
+	if (change == INVALID_HANDLE_VALUE) {
+		printf("Could not watch %S for changes: %x\n", directory.c_str(), GetLastError());
+		return 1;
+	}
+
+	TaskSchedulerSession session;
+	if (!session.IsConnected()) {
+		printf("Could not connect to the task scheduler\n");
+		FindCloseChangeNotification(change);
+		return 10;
+	}
+
+	// The snapshot is optional, tasks are still kept in sync without it
+	TaskSnapshotWriter snapshot;
+	if (!snapshot.Create(SNAPSHOT_NAME, SNAPSHOT_CAPACITY)) {
+		printf("Could not create the snapshot, query will not be available\n");
+	}
+
+	// The tasks registered from the manifest. Everything in the manifest is registered once at the start.
+	LiveTasks live;
+	FILETIME lastWrite = {};
+	uint64_t size = 0;
+	GetFileVersion(path, lastWrite, size);
+	SyncManifest(session, path, live);
+	PublishSnapshot(session, live, snapshot);
+	ClockReading clocks = ReadClocks();
+
+	for (;;) {
+		DWORD wait = WaitForSingleObject(change, SNAPSHOT_MS);
+
+		// Republish straight away after a clock change or a resume, rather than showing stale next runs
+		ClockReading newClocks = ReadClocks();
+		if (CheckClockJump(live, clocks, newClocks) && wait != WAIT_TIMEOUT) {
+			PublishSnapshot(session, live, snapshot);
+		}
+		clocks = newClocks;
+
+		if (wait == WAIT_TIMEOUT) {
+			PublishSnapshot(session, live, snapshot);
+			continue;
+		}
+		if (wait != WAIT_OBJECT_0) {
+			break;
+		}
+
+		Sleep(SETTLE_MS);
+		if (!FindNextChangeNotification(change)) {
+			printf("Could not watch %S for changes: %x\n", directory.c_str(), GetLastError());
+			break;
+		}
+
+		// Other files in the directory may have changed, only re-read the manifest if it did
+		FILETIME newLastWrite = {};
+		uint64_t newSize = 0;
+		if (!GetFileVersion(path, newLastWrite, newSize) ||
+			(CompareFileTime(&newLastWrite, &lastWrite) == 0 && newSize == size)) {
+			continue;
+		}
+		lastWrite = newLastWrite;
+		size = newSize;
+		SyncManifest(session, path, live);
+		PublishSnapshot(session, live, snapshot);
+	}
+
+	FindCloseChangeNotification(change);
+	return 10;
+}
+
 static int RunTest(int argc, const wchar_t **argv) 
 {
 	wchar_t exePath[MAX_PATH] = { 0 };
@@ -223,6 +1237,113 @@ static int RunTest(int argc, const wchar_t **argv)
 	return success ? 0 : 100;
 }
 
+// Print the distribution of a set of latencies, in milliseconds
+static void PrintLatencies(const char *name, std::vector<double> &latencies)
+{
+	if (latencies.empty()) {
+		printf("%-9s no samples\n", name);
+		return;
+	}
+
+	// Nearest-rank percentiles
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&latencies](double p) {
+		size_t rank = (size_t)(p * latencies.size() + 0.999999);
+		return latencies[rank ? rank - 1 : 0];
+	};
+	printf("%-9s min %8.1f  p50 %8.1f  p90 %8.1f  p99 %8.1f  max %8.1f ms (%u samples)\n", name,
+		latencies.front(), percentile(0.5), percentile(0.9), percentile(0.99), latencies.back(),
+		(unsigned)latencies.size());
+}
+
+static int RunProbe(int argc, const wchar_t **argv)
+{
+	// How far ahead each run is scheduled, as start times are in whole seconds
+	static const int32_t LEAD_SECONDS = 2;
+	// How long to wait for a run after its due time, before counting it as missed
+	static const DWORD TIMEOUT_MS = 10000;
+
+	uint32_t rounds = 10;
+	if (argc > 2) {
+		wchar_t *end = NULL;
+		rounds = (uint32_t)wcstoul(argv[2], &end, 10);
+		if (*end != L'\0' || rounds == 0) {
+			PrintUsage(argc, argv);
+			return 1;
+		}
+	}
+
+	wchar_t exePath[MAX_PATH] = { 0 };
+	if (0 == GetModuleFileName(NULL, exePath, MAX_PATH)) {
+		printf("Could not get executable name: %x\n", GetLastError());
+		return 10;
+	}
+
+	HANDLE hEvent = CreateEvent(NULL, TRUE, FALSE, TEST_EVENT_NAME);
+	if (hEvent == NULL) {
+		printf("Could not create task event, exiting\n");
+		return 10;
+	}
+
+	TaskSchedulerSession session;
+	if (!session.IsConnected()) {
+		printf("Could not connect to the task scheduler\n");
+		CloseHandle(hEvent);
+		return 10;
+	}
+
+	static const wchar_t* PROBE_ARGV[] = { L"signal" };
+	TaskDefinition task;
+	task.SetName(TEST_TASK_NAME);
+	task.SetExecutable(exePath);
+	task.SetArguments(PROBE_ARGV, 1);
+
+	std::vector<double> registerLatencies, fireLatencies;
+	uint32_t failures = 0;
+	for (uint32_t round = 0; round < rounds; round++) {
+		ResetEvent(hEvent);
+
+		// Each round replaces the previous definition of the task, with a new start time
+		DateSpec date;
+		TimeSpec time;
+		time_t due = ::time(NULL) + LEAD_SECONDS;
+		TimeToTimeSpec(due, date, time);
+		task.SetStartDate(date);
+		task.SetDailyStartTime(time);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		ScheduleTaskResult result = session.RegisterTask(task);
+		registerLatencies.push_back(
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		if (result != SCHEDULE_TASK_OK) {
+			printf("Round %u: could not schedule the task\n", round + 1);
+			failures++;
+			continue;
+		}
+
+		// The latency runs from the due time until the action has started and signalled the event
+		if (WaitForSingleObject(hEvent, LEAD_SECONDS * 1000 + TIMEOUT_MS) == WAIT_OBJECT_0) {
+			double latency = (double)(GetWallClockMs() - (int64_t)due * 1000);
+			fireLatencies.push_back(latency);
+			printf("Round %u: started %.0f ms after its due time\n", round + 1, latency);
+		} else {
+			printf("Round %u: timed out waiting for the task to start\n", round + 1);
+			failures++;
+		}
+		fflush(stdout);
+	}
+
+	if (!session.DeleteTask(TEST_TASK_NAME)) {
+		printf("Could not delete the task <%S>. You should manually delete this task!\n", TEST_TASK_NAME);
+	}
+	CloseHandle(hEvent);
+
+	PrintLatencies("register", registerLatencies);
+	PrintLatencies("fire", fireLatencies);
+	printf("%u of %u rounds failed\n", failures, rounds);
+	return failures ? 100 : 0;
+}
+
 static int SignalEvent() 
 {
 	HANDLE hEvent = OpenEvent(EVENT_MODIFY_STATE, FALSE, TEST_EVENT_NAME);
@@ -238,3 +1359,101 @@ static int SignalEvent()
 	return 0;
 }
 
+
+static int RunCapture(int argc, const wchar_t **argv)
+{
+	// Enough to drain a burst of output without the child blocking on a full pipe
+	static const DWORD PIPE_BUFFER_SIZE = 64 * 1024;
+
+	if (argc < 6) {
+		PrintUsage(argc, argv);
+		return 1;
+	}
+
+	wchar_t *sizeEnd = NULL, *filesEnd = NULL;
+	uint64_t maxBytes = _wcstoui64(argv[3], &sizeEnd, 10);
+	unsigned long maxFiles = wcstoul(argv[4], &filesEnd, 10);
+	if (*sizeEnd != L'\0' || *filesEnd != L'\0' || maxBytes == 0 || maxFiles == 0) {
+		PrintUsage(argc, argv);
+		return 1;
+	}
+
+	// The log can't be opened while another run has it, e.g. with /MI parallel. Missing output is better
+	// than a missed run, so the program still runs, with its output discarded.
+	RotatingLog log;
+	bool logged = log.Open(argv[2], maxBytes, (uint32_t)maxFiles);
+	if (!logged) {
+		fprintf(stderr, "The output of %S will not be logged\n", argv[5]);
+	}
+
+	// The child writes both stdout and stderr into the pipe, and only the read end stays with us
+	SECURITY_ATTRIBUTES inherit = { sizeof(inherit), NULL, TRUE };
+	HANDLE readPipe = NULL, writePipe = NULL;
+	if (!CreatePipe(&readPipe, &writePipe, &inherit, PIPE_BUFFER_SIZE)) {
+		printf("Could not create output pipe: %x\n", GetLastError());
+		return 10;
+	}
+	SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+	// Put the child in a job, so it doesn't outlive us if the task is stopped for its time limit
+	HANDLE job = CreateJobObject(NULL, NULL);
+	if (job != NULL) {
+		JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = {};
+		limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+		SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+	}
+
+	// The program is the first token of the command line, rather than the application name, so that it
+	// is found on the PATH and .exe may be left off, as when the task service runs it without /LOG
+	std::wstring commandLine;
+	BuildArgumentString(commandLine, argv + 5, argc - 5);
+
+	STARTUPINFOW startup = { sizeof(startup) };
+	startup.dwFlags = STARTF_USESTDHANDLES;
+	startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+	startup.hStdOutput = writePipe;
+	startup.hStdError = writePipe;
+	PROCESS_INFORMATION process = {};
+	BOOL created = CreateProcessW(NULL, &commandLine[0], NULL, NULL, TRUE, CREATE_SUSPENDED, NULL, NULL,
+		&startup, &process);
+
+	// Close our copy of the write end, so reads fail once the child (and anything it started) exits
+	CloseHandle(writePipe);
+	if (!created) {
+		printf("Could not start %S: %x\n", argv[5], GetLastError());
+		CloseHandle(readPipe);
+		if (job != NULL) {
+			CloseHandle(job);
+		}
+		return 10;
+	}
+	if (job != NULL) {
+		AssignProcessToJobObject(job, process.hProcess);
+	}
+	ResumeThread(process.hThread);
+	CloseHandle(process.hThread);
+
+	// Copy the output into the log as it arrives. Nothing is buffered here, so the log is
+	// complete up to the last read even if we are killed.
+	std::vector<char> buffer(PIPE_BUFFER_SIZE);
+	DWORD read = 0;
+	while (ReadFile(readPipe, buffer.data(), (DWORD)buffer.size(), &read, NULL) && read > 0) {
+		// Keep draining the pipe if the log can't be written, so the child isn't blocked
+		if (logged && !log.Write(buffer.data(), read)) {
+			logged = false;
+		}
+	}
+	CloseHandle(readPipe);
+	log.Close();
+
+	WaitForSingleObject(process.hProcess, INFINITE);
+	DWORD exitCode = 10;
+	GetExitCodeProcess(process.hProcess, &exitCode);
+	CloseHandle(process.hProcess);
+	if (job != NULL) {
+		CloseHandle(job);
+	}
+
+	// Report the child's result, so the last run result and /AFTER dependencies see it
+	return (int)exitCode;
+}
@@ -0,0 +1,112 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestBlackoutCalendar)
+	{
+	public:
+
+		static int64_t ToTime(const DateSpec &date, const TimeSpec &time)
+		{
+			return (int64_t)DateToDays(date) * SECONDS_PER_DAY + time.GetTotalSeconds();
+		}
+
+		TEST_METHOD(AddAndRemoveDays)
+		{
+			BlackoutCalendar calendar;
+			Assert::IsFalse(calendar.IsBlackedOut(DateToDays(DateSpec(2017, 11, 25))));
+
+			calendar.AddDays(DateSpec(2017, 11, 24), DateSpec(2017, 11, 26));
+			Assert::IsFalse(calendar.IsBlackedOut(DateToDays(DateSpec(2017, 11, 23))));
+			Assert::IsTrue(calendar.IsBlackedOut(DateToDays(DateSpec(2017, 11, 24))));
+			Assert::IsTrue(calendar.IsBlackedOut(DateToDays(DateSpec(2017, 11, 26))));
+			Assert::IsFalse(calendar.IsBlackedOut(DateToDays(DateSpec(2017, 11, 27))));
+
+			calendar.RemoveDays(DateSpec(2017, 11, 25), DateSpec(2017, 11, 25));
+			Assert::IsTrue(calendar.IsBlackedOut(DateToDays(DateSpec(2017, 11, 24))));
+			Assert::IsFalse(calendar.IsBlackedOut(DateToDays(DateSpec(2017, 11, 25))));
+
+			calendar.Clear();
+			Assert::IsFalse(calendar.IsBlackedOut(DateToDays(DateSpec(2017, 11, 24))));
+		}
+
+		TEST_METHOD(LeapDay)
+		{
+			BlackoutCalendar calendar;
+			calendar.AddDays(DateSpec(2020, 11, 30), DateSpec(2020, 11, 30));
+			Assert::IsTrue(calendar.IsBlackedOut(DateToDays(DateSpec(2020, 11, 30))));
+			Assert::IsFalse(calendar.IsBlackedOut(DateToDays(DateSpec(2021, 0, 0))));
+			Assert::AreEqual(DateToDays(DateSpec(2021, 0, 0)), calendar.GetNextAllowedDay(DateToDays(DateSpec(2020, 11, 30))));
+		}
+
+		TEST_METHOD(NextAllowedDayAcrossYears)
+		{
+			// A freeze of more than 64 days, across the end of a year
+			BlackoutCalendar calendar;
+			calendar.AddDays(DateSpec(2017, 10, 0), DateSpec(2018, 1, 27));
+			Assert::AreEqual(DateToDays(DateSpec(2018, 2, 0)), calendar.GetNextAllowedDay(DateToDays(DateSpec(2017, 10, 0))));
+			Assert::AreEqual(DateToDays(DateSpec(2017, 9, 30)), calendar.GetNextAllowedDay(DateToDays(DateSpec(2017, 9, 30))));
+			Assert::AreEqual(DateToDays(DateSpec(2030, 0, 0)), calendar.GetNextAllowedDay(DateToDays(DateSpec(2030, 0, 0))));
+		}
+
+		TEST_METHOD(NextBlackedOutDay)
+		{
+			BlackoutCalendar calendar;
+			calendar.AddDays(DateSpec(2018, 11, 24), DateSpec(2018, 11, 25));
+			int32_t endDay = DateToDays(DateSpec(2019, 0, 0));
+			Assert::AreEqual(DateToDays(DateSpec(2018, 11, 24)), calendar.GetNextBlackedOutDay(DateToDays(DateSpec(2017, 0, 0)), endDay));
+			Assert::AreEqual(DateToDays(DateSpec(2018, 11, 25)), calendar.GetNextBlackedOutDay(DateToDays(DateSpec(2018, 11, 25)), endDay));
+			Assert::AreEqual(endDay, calendar.GetNextBlackedOutDay(DateToDays(DateSpec(2018, 11, 26)), endDay));
+			Assert::AreEqual(NO_END_DAY, calendar.GetNextBlackedOutDay(DateToDays(DateSpec(2018, 11, 26)), NO_END_DAY));
+		}
+
+		TEST_METHOD(ContentHash)
+		{
+			BlackoutCalendar calendar;
+			uint64_t empty = calendar.GetContentHash();
+
+			calendar.AddDays(DateSpec(2017, 11, 25), DateSpec(2017, 11, 25));
+			uint64_t christmas = calendar.GetContentHash();
+			Assert::AreNotEqual(empty, christmas);
+
+			calendar.RemoveDays(DateSpec(2017, 11, 25), DateSpec(2017, 11, 25));
+			Assert::AreEqual(empty, calendar.GetContentHash());
+		}
+
+		TEST_METHOD(NextRunSkipsBlackout)
+		{
+			BlackoutCalendar calendar;
+			calendar.AddDays(DateSpec(2017, 11, 25), DateSpec(2017, 11, 26));
+
+			int64_t now = ToTime(DateSpec(2017, 11, 25), TimeSpec(8, 0, 0));
+			Assert::AreEqual(ToTime(DateSpec(2017, 11, 27), TimeSpec(9, 30, 0)),
+				GetNextDailyRun(DateSpec(2017, 0, 0), DateSpec(), TimeSpec(9, 30, 0), now, calendar));
+
+			// The schedule ends before the next allowed day
+			Assert::AreEqual(NO_NEXT_RUN,
+				GetNextDailyRun(DateSpec(2017, 0, 0), DateSpec(2017, 11, 27), TimeSpec(9, 30, 0), now, calendar));
+		}
+
+		TEST_METHOD(SkipBlackoutDaysColumns)
+		{
+			BlackoutCalendar calendar;
+			calendar.AddDays(DateSpec(2017, 11, 25), DateSpec(2017, 11, 25));
+
+			int32_t startDays[] = { NO_START_DAY, NO_START_DAY };
+			int32_t endDays[] = { NO_END_DAY, NO_END_DAY };
+			int32_t startSeconds[] = { 9 * 3600, 9 * 3600 };
+			DailyScheduleColumns columns = { startDays, endDays, startSeconds, 2 };
+			const BlackoutCalendar *calendars[] = { &calendar, NULL };
+
+			int64_t now = ToTime(DateSpec(2017, 11, 25), TimeSpec(8, 0, 0));
+			int64_t nextRuns[2];
+			GetNextDailyRuns(columns, now, nextRuns);
+			SkipBlackoutDays(columns, calendars, nextRuns);
+			Assert::AreEqual(ToTime(DateSpec(2017, 11, 26), TimeSpec(9, 0, 0)), nextRuns[0]);
+			Assert::AreEqual(ToTime(DateSpec(2017, 11, 25), TimeSpec(9, 0, 0)), nextRuns[1]);
+		}
+	};
+}
@@ -0,0 +1,86 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestClockJump)
+	{
+	public:
+
+		// A virtual clock, starting at 2017-11-01 02:30:00 UTC after an hour awake
+		static ClockReading Start()
+		{
+			ClockReading reading;
+			reading.wallMs = 1509503400000ll;
+			reading.tickMs = 3600000;
+			reading.unbiasedMs = 3600000;
+			return reading;
+		}
+
+		// Advance the virtual clock, by time awake, time suspended and a step of the wall clock
+		static ClockReading Advance(const ClockReading &last, int64_t awakeMs, int64_t suspendedMs, int64_t stepMs)
+		{
+			ClockReading reading;
+			reading.wallMs = last.wallMs + awakeMs + suspendedMs + stepMs;
+			reading.tickMs = last.tickMs + awakeMs + suspendedMs;
+			reading.unbiasedMs = last.unbiasedMs + awakeMs;
+			return reading;
+		}
+
+		TEST_METHOD(ForwardStep)
+		{
+			ClockReading last = Start();
+			ClockReading now = Advance(last, 60000, 0, 3600000);
+			int64_t stepped, suspended, from, to;
+			Assert::IsTrue(ClassifyClockJump(last, now, stepped, suspended, from, to));
+			Assert::AreEqual((int64_t)3600000, stepped);
+			Assert::AreEqual((int64_t)0, suspended);
+			// The hour after where the clock should be was skipped
+			Assert::AreEqual(last.wallMs + 60000, from);
+			Assert::AreEqual(from + 3600000, to);
+		}
+
+		TEST_METHOD(BackwardStep)
+		{
+			ClockReading last = Start();
+			ClockReading now = Advance(last, 60000, 0, -600000);
+			int64_t stepped, suspended, from, to;
+			Assert::IsTrue(ClassifyClockJump(last, now, stepped, suspended, from, to));
+			Assert::AreEqual((int64_t)-600000, stepped);
+			Assert::AreEqual((int64_t)0, suspended);
+			// The ten minutes before where the clock should be are repeated
+			Assert::AreEqual(last.wallMs + 60000, from);
+			Assert::AreEqual(from - 600000, to);
+		}
+
+		TEST_METHOD(Suspend)
+		{
+			ClockReading last = Start();
+			ClockReading now = Advance(last, 30000, 8 * 3600000ll, 0);
+			int64_t stepped, suspended, from, to;
+			Assert::IsTrue(ClassifyClockJump(last, now, stepped, suspended, from, to));
+			Assert::AreEqual((int64_t)0, stepped);
+			Assert::AreEqual(8 * 3600000ll, suspended);
+			// The time suspended was skipped
+			Assert::AreEqual(last.wallMs + 30000, from);
+			Assert::AreEqual(from + 8 * 3600000ll, to);
+		}
+
+		TEST_METHOD(DriftUnderTolerance)
+		{
+			ClockReading last = Start();
+			int64_t stepped, suspended, from, to;
+			Assert::IsFalse(ClassifyClockJump(last, Advance(last, 60000, 0, 1999), stepped, suspended, from, to));
+			Assert::AreEqual((int64_t)1999, stepped);
+			Assert::IsFalse(ClassifyClockJump(last, Advance(last, 60000, 0, -1999), stepped, suspended, from, to));
+			Assert::IsFalse(ClassifyClockJump(last, Advance(last, 60000, 1500, 0), stepped, suspended, from, to));
+			Assert::AreEqual((int64_t)1500, suspended);
+
+			// At the tolerance it counts
+			Assert::IsTrue(ClassifyClockJump(last, Advance(last, 60000, 0, -2000), stepped, suspended, from, to));
+			Assert::IsTrue(ClassifyClockJump(last, Advance(last, 60000, 2000, 0), stepped, suspended, from, to));
+		}
+	};
+}
@@ -0,0 +1,76 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestCommandLine)
+	{
+	public:
+
+		TEST_METHOD(NoArguments)
+		{
+			std::wstring args(L"previous");
+			BuildArgumentString(args, NULL, 0);
+			Assert::AreEqual(L"", args.c_str());
+		}
+
+		TEST_METHOD(SimpleArguments)
+		{
+			const wchar_t *argv[] = { L"signal", L"/quiet" };
+			std::wstring args;
+			BuildArgumentString(args, argv, 2);
+			Assert::AreEqual(L"signal /quiet", args.c_str());
+		}
+
+		TEST_METHOD(NullAndEmptyArguments)
+		{
+			const wchar_t *argv[] = { L"a", NULL, L"", L"b" };
+			std::wstring args;
+			BuildArgumentString(args, argv, 4);
+			Assert::AreEqual(L"a \"\" b", args.c_str());
+		}
+
+		TEST_METHOD(ArgumentsWithSpaces)
+		{
+			const wchar_t *argv[] = { L"C:\\Program Files\\app.exe", L"two words" };
+			std::wstring args;
+			BuildArgumentString(args, argv, 2);
+			Assert::AreEqual(L"\"C:\\Program Files\\app.exe\" \"two words\"", args.c_str());
+		}
+
+		TEST_METHOD(ArgumentsWithQuotesAndBackslashes)
+		{
+			const wchar_t *argv[] = { L"say \"hi\"", L"C:\\dir with space\\", L"a\\\\b", L"x\\\"y" };
+			std::wstring args;
+			BuildArgumentString(args, argv, 4);
+			Assert::AreEqual(L"\"say \\\"hi\\\"\" \"C:\\dir with space\\\\\" a\\\\b \"x\\\\\\\"y\"", args.c_str());
+		}
+
+		TEST_METHOD(ArgumentsRoundTrip)
+		{
+			const wchar_t *argv[] = { L"exe", L"plain", L"with space", L"q\"uote", L"trailing\\", L"" };
+			const int argc = sizeof(argv) / sizeof(argv[0]);
+			std::wstring args;
+			BuildArgumentString(args, argv, argc);
+
+			int parsedArgc = 0;
+			LPWSTR *parsedArgv = CommandLineToArgvW(args.c_str(), &parsedArgc);
+			Assert::IsNotNull(parsedArgv);
+			Assert::AreEqual(argc, parsedArgc);
+			for (int i = 0; i < argc; i++) {
+				Assert::AreEqual(argv[i], parsedArgv[i]);
+			}
+			LocalFree(parsedArgv);
+		}
+
+		TEST_METHOD(Utf8Arguments)
+		{
+			const char *argv[] = { "caf\xc3\xa9", "two words" };
+			std::string args;
+			BuildArgumentString(args, argv, 2);
+			Assert::AreEqual("caf\xc3\xa9 \"two words\"", args.c_str());
+		}
+	};
+}
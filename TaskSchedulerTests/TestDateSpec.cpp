@@ -2,6 +2,7 @@
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace task_scheduler;
+using namespace task_scheduler::literals;
 
 namespace TaskSchedulerTests
 {		
@@ -64,5 +65,45 @@ namespace TaskSchedulerTests
 			Assert::AreEqual(0, (int)spec.GetMonth());
 			Assert::AreEqual(14, (int)spec.GetDay());
 		}
+
+		TEST_METHOD(ConstantExpression)
+		{
+			constexpr DateSpec spec(2017, 8, 17);
+			static_assert(spec.GetYear() == 2017, "Expected constexpr year");
+			static_assert(spec.GetMonth() == 8, "Expected constexpr month");
+			static_assert(spec.GetDay() == 17, "Expected constexpr day");
+			static_assert(DateSpec(2017, 12, 31) == DateSpec(2017, 0, 0), "Expected invalid values to default to 0");
+		}
+
+		TEST_METHOD(DateLiteral)
+		{
+			constexpr DateSpec spec = "2024/01/31"_date;
+			static_assert(spec == DateSpec(2024, 0, 30), "Expected 2024/01/31");
+			static_assert("2024/02/29"_date == DateSpec(2024, 1, 28), "Expected leap day");
+			Assert::AreEqual(2024, (int)spec.GetYear());
+			Assert::AreEqual(0, (int)spec.GetMonth());
+			Assert::AreEqual(30, (int)spec.GetDay());
+		}
+
+		TEST_METHOD(DateLiteralInvalid)
+		{
+			// Evaluated at runtime, so that these throw instead of failing to compile
+			Assert::ExpectException<std::invalid_argument>([] { return "2024-01-31"_date; });
+			Assert::ExpectException<std::invalid_argument>([] { return "2024/1/31"_date; });
+			Assert::ExpectException<std::out_of_range>([] { return "2024/13/01"_date; });
+			Assert::ExpectException<std::out_of_range>([] { return "2024/04/31"_date; });
+			Assert::ExpectException<std::out_of_range>([] { return "2023/02/29"_date; });
+			Assert::ExpectException<std::out_of_range>([] { return "1969/01/15"_date; });
+		}
+
+		TEST_METHOD(DaysInMonthLeapYears)
+		{
+			static_assert(DaysInMonth(2016, 1) == 29, "2016 is a leap year");
+			static_assert(DaysInMonth(2017, 1) == 28, "2017 is not a leap year");
+			static_assert(DaysInMonth(1900, 1) == 28, "1900 is not a leap year");
+			static_assert(DaysInMonth(2000, 1) == 29, "2000 is a leap year");
+			static_assert(DaysInMonth(2017, 3) == 30, "April has 30 days");
+			static_assert(DaysInMonth(2017, 11) == 31, "December has 31 days");
+		}
 	};
 }
\ No newline at end of file
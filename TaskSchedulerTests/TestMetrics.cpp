@@ -0,0 +1,57 @@
+#include "stdafx.h"
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestMetrics)
+	{
+	public:
+
+		TEST_METHOD(CountersAccumulate)
+		{
+			uint64_t before = GetMetricCounter(METRIC_TASKS_DELETED);
+			AddMetricCounter(METRIC_TASKS_DELETED);
+			AddMetricCounter(METRIC_TASKS_DELETED, 2);
+			Assert::AreEqual(before + 3, GetMetricCounter(METRIC_TASKS_DELETED));
+		}
+
+		TEST_METHOD(CountersMergeThreads)
+		{
+			uint64_t before = GetMetricCounter(METRIC_DEFINITIONS_BUILT);
+			std::thread other([]() {
+				AddMetricCounter(METRIC_DEFINITIONS_BUILT, 5);
+			});
+			other.join();
+			AddMetricCounter(METRIC_DEFINITIONS_BUILT);
+
+			// The other thread's counts are kept after it exits
+			Assert::AreEqual(before + 6, GetMetricCounter(METRIC_DEFINITIONS_BUILT));
+		}
+
+		TEST_METHOD(DurationsAreCounted)
+		{
+			uint64_t before = GetMetricDurationCount(METRIC_CONNECT_DURATION);
+			RecordMetricDuration(METRIC_CONNECT_DURATION, 10);
+			RecordMetricDuration(METRIC_CONNECT_DURATION, 10000000);
+			{
+				MetricTimer timer(METRIC_CONNECT_DURATION);
+			}
+			Assert::AreEqual(before + 3, GetMetricDurationCount(METRIC_CONNECT_DURATION));
+		}
+
+		TEST_METHOD(PrometheusFormat)
+		{
+			std::string text;
+			FormatMetrics(text);
+
+			Assert::IsTrue(text.find("# TYPE task_scheduler_tasks_registered_total counter\n") != std::string::npos);
+			Assert::IsTrue(text.find("# TYPE task_scheduler_register_duration_seconds histogram\n") != std::string::npos);
+			Assert::IsTrue(text.find("task_scheduler_register_duration_seconds_bucket{le=\"0.001\"} ") != std::string::npos);
+			Assert::IsTrue(text.find("task_scheduler_register_duration_seconds_bucket{le=\"+Inf\"} ") != std::string::npos);
+			Assert::IsTrue(text.find("task_scheduler_register_duration_seconds_count ") != std::string::npos);
+		}
+	};
+}
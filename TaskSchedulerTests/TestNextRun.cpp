@@ -0,0 +1,98 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestNextRun)
+	{
+	public:
+
+		static int64_t ToTime(const DateSpec &date, const TimeSpec &time)
+		{
+			return (int64_t)DateToDays(date) * SECONDS_PER_DAY + time.GetTotalSeconds();
+		}
+
+		TEST_METHOD(DateToDaysRoundTrip)
+		{
+			Assert::AreEqual(0, DateToDays(DateSpec(1970, 0, 0)));
+			Assert::AreEqual(11016, DateToDays(DateSpec(2000, 1, 28)));
+			for (int32_t days = 0; days < 50000; days += 7) {
+				DateSpec date = DaysToDate(days);
+				Assert::AreEqual(days, DateToDays(date));
+			}
+		}
+
+		TEST_METHOD(LaterToday)
+		{
+			int64_t now = ToTime(DateSpec(2017, 8, 17), TimeSpec(8, 0, 0));
+			int64_t next = GetNextDailyRun(DateSpec(2017, 0, 0), DateSpec(), TimeSpec(9, 30, 0), now);
+			Assert::AreEqual(ToTime(DateSpec(2017, 8, 17), TimeSpec(9, 30, 0)), next);
+		}
+
+		TEST_METHOD(AtCurrentTime)
+		{
+			int64_t now = ToTime(DateSpec(2017, 8, 17), TimeSpec(9, 30, 0));
+			Assert::AreEqual(now, GetNextDailyRun(DateSpec(2017, 0, 0), DateSpec(), TimeSpec(9, 30, 0), now));
+		}
+
+		TEST_METHOD(Tomorrow)
+		{
+			int64_t now = ToTime(DateSpec(2017, 11, 30), TimeSpec(10, 0, 0));
+			int64_t next = GetNextDailyRun(DateSpec(2017, 0, 0), DateSpec(), TimeSpec(9, 30, 0), now);
+			Assert::AreEqual(ToTime(DateSpec(2018, 0, 0), TimeSpec(9, 30, 0)), next);
+		}
+
+		TEST_METHOD(BeforeStartDate)
+		{
+			int64_t now = ToTime(DateSpec(2017, 8, 17), TimeSpec(8, 0, 0));
+			int64_t next = GetNextDailyRun(DateSpec(2017, 9, 0), DateSpec(), TimeSpec(9, 30, 0), now);
+			Assert::AreEqual(ToTime(DateSpec(2017, 9, 0), TimeSpec(9, 30, 0)), next);
+		}
+
+		TEST_METHOD(AfterEndDate)
+		{
+			int64_t now = ToTime(DateSpec(2017, 8, 17), TimeSpec(10, 0, 0));
+			// The next run would be on the end date, which is after the end boundary
+			Assert::AreEqual(NO_NEXT_RUN, GetNextDailyRun(DateSpec(2017, 0, 0), DateSpec(2017, 8, 18),
+				TimeSpec(9, 30, 0), now));
+			Assert::AreEqual(ToTime(DateSpec(2017, 8, 18), TimeSpec(9, 30, 0)),
+				GetNextDailyRun(DateSpec(2017, 0, 0), DateSpec(2017, 8, 19), TimeSpec(9, 30, 0), now));
+		}
+
+		TEST_METHOD(VectorizedMatchesScalar)
+		{
+			// Cover every combination of before/after the current time, start and end date,
+			// with a count that isn't a multiple of the vector width
+			const size_t count = 1003;
+			std::vector<int32_t> startDays(count), endDays(count), startSeconds(count);
+			int32_t today = DateToDays(DateSpec(2017, 8, 17));
+			for (size_t i = 0; i < count; i++) {
+				startDays[i] = (i % 3 == 0) ? NO_START_DAY : today + (int32_t)(i % 7) - 3;
+				endDays[i] = (i % 4 == 0) ? NO_END_DAY : today + (int32_t)(i % 5) - 2;
+				startSeconds[i] = (int32_t)((i * 7919) % SECONDS_PER_DAY);
+			}
+
+			DailyScheduleColumns columns;
+			columns.startDays = startDays.data();
+			columns.endDays = endDays.data();
+			columns.startSeconds = startSeconds.data();
+			columns.count = count;
+
+			int64_t times[] = {
+				(int64_t)today * SECONDS_PER_DAY,
+				(int64_t)today * SECONDS_PER_DAY + 43200,
+				(int64_t)today * SECONDS_PER_DAY + SECONDS_PER_DAY - 1,
+			};
+			for (int64_t now : times) {
+				std::vector<int64_t> scalarRuns(count), vectorRuns(count);
+				GetNextDailyRunsScalar(columns, now, scalarRuns.data());
+				GetNextDailyRuns(columns, now, vectorRuns.data());
+				for (size_t i = 0; i < count; i++) {
+					Assert::AreEqual(scalarRuns[i], vectorRuns[i]);
+				}
+			}
+		}
+	};
+}
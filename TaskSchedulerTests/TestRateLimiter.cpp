@@ -0,0 +1,81 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestRateLimiter)
+	{
+	public:
+
+		TEST_METHOD(UnlimitedWithoutPrefix)
+		{
+			RateLimiter limiter;
+			limiter.SetLimit(L"service-", 1, 1);
+			for (int i = 0; i < 100; i++) {
+				Assert::AreEqual((int64_t)0, limiter.Reserve(L"other-task", 0));
+			}
+		}
+
+		TEST_METHOD(BurstThenRefill)
+		{
+			// Two calls at once, then one every half second
+			RateLimiter limiter;
+			limiter.SetLimit(L"", 2, 2);
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"a", 0));
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"b", 0));
+			Assert::AreEqual(RATE_LIMIT_REJECTED, limiter.Reserve(L"c", 0));
+			Assert::AreEqual(RATE_LIMIT_REJECTED, limiter.Reserve(L"c", 499999));
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"c", 500000));
+			Assert::AreEqual(RATE_LIMIT_REJECTED, limiter.Reserve(L"d", 500000));
+
+			// The bucket never holds more than the burst
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"d", 100000000));
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"e", 100000000));
+			Assert::AreEqual(RATE_LIMIT_REJECTED, limiter.Reserve(L"f", 100000000));
+		}
+
+		TEST_METHOD(WaitQueuesBehindEarlierCalls)
+		{
+			// One call per 10 ms, and calls may wait up to 25 ms
+			RateLimiter limiter;
+			limiter.SetLimit(L"", 100, 1, 25);
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"a", 0));
+			Assert::AreEqual((int64_t)10000, limiter.Reserve(L"a", 0));
+			Assert::AreEqual((int64_t)20000, limiter.Reserve(L"a", 0));
+			Assert::AreEqual(RATE_LIMIT_REJECTED, limiter.Reserve(L"a", 0));
+			Assert::AreEqual((int64_t)25000, limiter.Reserve(L"a", 5000));
+		}
+
+		TEST_METHOD(LongestPrefixWins)
+		{
+			RateLimiter limiter;
+			limiter.SetLimit(L"", 0, 100);
+			limiter.SetLimit(L"service-", 0, 1);
+			limiter.SetLimit(L"service-critical-", 0, 2);
+
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"SERVICE-1", 0));
+			Assert::AreEqual(RATE_LIMIT_REJECTED, limiter.Reserve(L"service-2", 0));
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"service-critical-1", 0));
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"service-critical-2", 0));
+			Assert::AreEqual(RATE_LIMIT_REJECTED, limiter.Reserve(L"service-critical-3", 0));
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"other", 0));
+
+			limiter.RemoveLimit(L"service-");
+			Assert::AreEqual((int64_t)0, limiter.Reserve(L"service-3", 0));
+		}
+
+		TEST_METHOD(AcquireCountsRejections)
+		{
+			RateLimiter limiter;
+			limiter.SetLimit(L"", 0, 1);
+			uint64_t rejected = GetMetricCounter(METRIC_RATE_LIMITED);
+			uint64_t waits = GetMetricDurationCount(METRIC_RATE_LIMIT_WAIT);
+			Assert::IsTrue(limiter.Acquire(L"a"));
+			Assert::IsFalse(limiter.Acquire(L"a"));
+			Assert::AreEqual(rejected + 1, GetMetricCounter(METRIC_RATE_LIMITED));
+			Assert::AreEqual(waits + 1, GetMetricDurationCount(METRIC_RATE_LIMIT_WAIT));
+		}
+	};
+}
@@ -0,0 +1,125 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestRotatingLog)
+	{
+	public:
+
+		static std::wstring GetLogPath()
+		{
+			wchar_t path[MAX_PATH];
+			Assert::IsTrue(GetTempPathW(MAX_PATH, path) != 0);
+			return std::wstring(path) + L"TaskSchedulerTests.log";
+		}
+
+		// Read a whole file, or return "<missing>" if it doesn't exist
+		static std::string ReadLogFile(const std::wstring &path)
+		{
+			FILE *file = NULL;
+			if (_wfopen_s(&file, path.c_str(), L"rb") != 0 || !file) {
+				return "<missing>";
+			}
+			std::string contents;
+			char buffer[256];
+			size_t read;
+			while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+				contents.append(buffer, read);
+			}
+			fclose(file);
+			return contents;
+		}
+
+		static void DeleteLogFiles(const std::wstring &path)
+		{
+			DeleteFileW(path.c_str());
+			for (int i = 1; i < 5; i++) {
+				DeleteFileW((path + L"." + std::to_wstring(i)).c_str());
+			}
+		}
+
+		TEST_METHOD(RotatesAndDropsOldest)
+		{
+			std::wstring path = GetLogPath();
+			DeleteLogFiles(path);
+
+			RotatingLog log;
+			Assert::IsTrue(log.Open(path.c_str(), 4, 3));
+			Assert::IsTrue(log.Write("aaaabbbb", 8));
+			Assert::IsTrue(log.Write("cc", 2));
+			Assert::AreEqual(2u, log.GetRotationCount());
+			Assert::AreEqual(std::string("cc"), ReadLogFile(path));
+			Assert::AreEqual(std::string("bbbb"), ReadLogFile(path + L".1"));
+			Assert::AreEqual(std::string("aaaa"), ReadLogFile(path + L".2"));
+
+			Assert::IsTrue(log.Write("ccdddd", 6));
+			log.Close();
+			Assert::AreEqual(std::string("dddd"), ReadLogFile(path));
+			Assert::AreEqual(std::string("cccc"), ReadLogFile(path + L".1"));
+			Assert::AreEqual(std::string("bbbb"), ReadLogFile(path + L".2"));
+			Assert::AreEqual(std::string("<missing>"), ReadLogFile(path + L".3"));
+			DeleteLogFiles(path);
+		}
+
+		TEST_METHOD(ReopenAppends)
+		{
+			std::wstring path = GetLogPath();
+			DeleteLogFiles(path);
+
+			RotatingLog log;
+			Assert::IsTrue(log.Open(path.c_str(), 6, 2));
+			Assert::IsTrue(log.Write("abc", 3));
+			log.Close();
+			Assert::IsFalse(log.Write("x", 1));
+
+			// The existing contents count towards the cap
+			Assert::IsTrue(log.Open(path.c_str(), 6, 2));
+			Assert::IsTrue(log.Write("defg", 4));
+			log.Close();
+			Assert::AreEqual(1u, log.GetRotationCount());
+			Assert::AreEqual(std::string("g"), ReadLogFile(path));
+			Assert::AreEqual(std::string("abcdef"), ReadLogFile(path + L".1"));
+			DeleteLogFiles(path);
+		}
+
+		TEST_METHOD(EmptiedIfRenameFails)
+		{
+			std::wstring path = GetLogPath();
+			DeleteLogFiles(path);
+
+			RotatingLog log;
+			Assert::IsTrue(log.Open(path.c_str(), 4, 3));
+			Assert::IsTrue(log.Write("aaaa", 4));
+
+			// A reader that doesn't share deletes stops the file being renamed
+			HANDLE reader = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			Assert::IsTrue(reader != INVALID_HANDLE_VALUE);
+			Assert::IsTrue(log.Write("bbbbcc", 6));
+			Assert::AreEqual(2u, log.GetRotationCount());
+			CloseHandle(reader);
+
+			log.Close();
+			Assert::AreEqual(std::string("cc"), ReadLogFile(path));
+			Assert::AreEqual(std::string("<missing>"), ReadLogFile(path + L".1"));
+			DeleteLogFiles(path);
+		}
+
+		TEST_METHOD(SingleFileTruncates)
+		{
+			std::wstring path = GetLogPath();
+			DeleteLogFiles(path);
+
+			RotatingLog log;
+			Assert::IsTrue(log.Open(path.c_str(), 3, 1));
+			Assert::IsTrue(log.Write("abcdefgh", 8));
+			log.Close();
+			Assert::AreEqual(std::string("gh"), ReadLogFile(path));
+			Assert::AreEqual(std::string("<missing>"), ReadLogFile(path + L".1"));
+			DeleteLogFiles(path);
+		}
+	};
+}
@@ -0,0 +1,85 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestSpreadSchedule)
+	{
+	public:
+
+		TEST_METHOD(NoWindow)
+		{
+			Assert::AreEqual(0u, GetSpreadOffset(L"task", 0));
+
+			DateSpec startDate(2017, 7, 16);
+			TimeSpec startTime(23, 59, 0);
+			SpreadDailyStart(startDate, startTime, L"task", 0);
+			Assert::IsTrue(DateSpec(2017, 7, 16) == startDate);
+			Assert::IsTrue(TimeSpec(23, 59, 0) == startTime);
+		}
+
+		TEST_METHOD(OffsetIsStable)
+		{
+			Assert::AreEqual(GetSpreadOffset(L"nightly-backup", 3600), GetSpreadOffset(L"nightly-backup", 3600));
+			Assert::IsTrue(GetSpreadOffset(L"nightly-backup", 3600) < 3600u);
+		}
+
+		TEST_METHOD(OffsetIgnoresCase)
+		{
+			Assert::AreEqual(GetSpreadOffset(L"nightly-backup", 3600), GetSpreadOffset(L"Nightly-Backup", 3600));
+		}
+
+		TEST_METHOD(OffsetsAreEven)
+		{
+			// 60000 tasks over an hour should put about 1000 in each minute
+			static const uint32_t TASKS = 60000;
+			uint32_t perMinute[60] = {};
+			for (uint32_t i = 0; i < TASKS; i++) {
+				std::wstring name = L"task-" + std::to_wstring(i);
+				perMinute[GetSpreadOffset(name.c_str(), 3600) / 60]++;
+			}
+
+			for (int minute = 0; minute < 60; minute++) {
+				Assert::IsTrue(perMinute[minute] > 850 && perMinute[minute] < 1150);
+			}
+		}
+
+		TEST_METHOD(WrapsPastMidnight)
+		{
+			// Find a task whose offset takes it past midnight
+			std::wstring name;
+			for (int i = 0; ; i++) {
+				name = L"task-" + std::to_wstring(i);
+				if (GetSpreadOffset(name.c_str(), 7200) >= 3600) {
+					break;
+				}
+			}
+			uint32_t offset = GetSpreadOffset(name.c_str(), 7200);
+
+			DateSpec startDate(2017, 11, 30);
+			TimeSpec startTime(23, 0, 0);
+			SpreadDailyStart(startDate, startTime, name.c_str(), 7200);
+
+			Assert::IsTrue(DateSpec(2018, 0, 0) == startDate);
+			Assert::AreEqual((int32_t)(offset - 3600), startTime.GetTotalSeconds());
+		}
+
+		TEST_METHOD(DefinitionSpreadStart)
+		{
+			TaskDefinition task;
+			task.SetName(L"nightly-backup");
+			task.SetStartDate(DateSpec(2017, 7, 16));
+			task.SetSpreadWindow(600);
+
+			DateSpec startDate;
+			TimeSpec startTime;
+			task.GetSpreadStart(startDate, startTime);
+
+			Assert::IsTrue(DateSpec(2017, 7, 16) == startDate);
+			Assert::AreEqual((int32_t)GetSpreadOffset(L"nightly-backup", 600), startTime.GetTotalSeconds());
+			Assert::IsTrue(TimeSpec() == task.GetDailyStartTime());
+		}
+	};
+}
@@ -0,0 +1,100 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestTaskDefinition)
+	{
+	public:
+
+		TEST_METHOD(DefaultConstructor)
+		{
+			TaskDefinition task;
+			Assert::AreEqual(L"", task.GetName().c_str());
+			Assert::AreEqual(L"", task.GetExecutable().c_str());
+			Assert::AreEqual(L"", task.GetArguments());
+			Assert::AreEqual(0, (int)task.GetStartDate().GetYear());
+			Assert::AreEqual(0, (int)task.GetEndDate().GetYear());
+		}
+
+		TEST_METHOD(CopiesShareDefinition)
+		{
+			const wchar_t *argv[] = { L"--mode", L"nightly" };
+			TaskDefinition base;
+			base.SetExecutable(L"C:\\svc.exe");
+			base.SetStartDate(DateSpec(2017, 8, 17));
+			base.SetArguments(argv, 2);
+
+			TaskDefinition copy(base);
+			copy.SetName(L"copy");
+			copy.SetDailyStartTime(TimeSpec(8, 30, 0));
+
+			Assert::IsTrue(copy.SharesDefinitionWith(base));
+			Assert::AreEqual(L"C:\\svc.exe", copy.GetExecutable().c_str());
+			Assert::AreEqual(L"--mode nightly", copy.GetArguments());
+			Assert::AreEqual(L"", base.GetName().c_str());
+			Assert::AreEqual(0, (int)base.GetDailyStartTime().GetHour());
+		}
+
+		TEST_METHOD(OverrideArguments)
+		{
+			const wchar_t *baseArgv[] = { L"base" };
+			const wchar_t *copyArgv[] = { L"copy arg" };
+			TaskDefinition base;
+			base.SetArguments(baseArgv, 1);
+
+			TaskDefinition copy(base);
+			copy.SetArguments(copyArgv, 1);
+
+			Assert::IsTrue(copy.SharesDefinitionWith(base));
+			Assert::AreEqual(L"base", base.GetArguments());
+			Assert::AreEqual(L"\"copy arg\"", copy.GetArguments());
+		}
+
+		TEST_METHOD(CopyOnWrite)
+		{
+			TaskDefinition base;
+			base.SetExecutable(L"C:\\svc.exe");
+
+			TaskDefinition copy(base);
+			copy.SetExecutable(L"C:\\other.exe");
+
+			Assert::IsFalse(copy.SharesDefinitionWith(base));
+			Assert::AreEqual(L"C:\\svc.exe", base.GetExecutable().c_str());
+			Assert::AreEqual(L"C:\\other.exe", copy.GetExecutable().c_str());
+		}
+
+		TEST_METHOD(ModifyingOriginalLeavesCopyUnchanged)
+		{
+			TaskDefinition base;
+			base.SetEndDate(DateSpec(2018, 0, 0));
+
+			TaskDefinition copy(base);
+			base.SetEndDate(DateSpec(2019, 0, 0));
+
+			Assert::IsFalse(copy.SharesDefinitionWith(base));
+			Assert::AreEqual(2019, (int)base.GetEndDate().GetYear());
+			Assert::AreEqual(2018, (int)copy.GetEndDate().GetYear());
+		}
+
+		TEST_METHOD(SettingsCopyOnWrite)
+		{
+			TaskDefinition base;
+			Assert::IsTrue(base.GetSettings() == TaskSettings());
+
+			TaskSettings settings;
+			settings.executionTimeLimit = 3600;
+			settings.instancesPolicy = INSTANCES_QUEUE;
+
+			TaskDefinition copy(base);
+			copy.SetSettings(settings);
+
+			Assert::IsFalse(copy.SharesDefinitionWith(base));
+			Assert::AreEqual((int)TaskSettings::DEFAULT_EXECUTION_TIME_LIMIT, (int)base.GetSettings().executionTimeLimit);
+			Assert::AreEqual(3600, (int)copy.GetSettings().executionTimeLimit);
+			Assert::IsTrue(INSTANCES_QUEUE == copy.GetSettings().instancesPolicy);
+		}
+	};
+}
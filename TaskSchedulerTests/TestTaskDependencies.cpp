@@ -0,0 +1,98 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestTaskDependencies)
+	{
+	public:
+
+		TEST_METHOD(NoDependencies)
+		{
+			TaskDefinition tasks[2];
+			tasks[0].SetName(L"a");
+			tasks[1].SetName(L"b");
+
+			std::vector<size_t> order;
+			Assert::IsTrue(SortByDependencies(tasks, 2, order));
+			Assert::AreEqual((size_t)2, order.size());
+			Assert::AreEqual((size_t)0, order[0]);
+			Assert::AreEqual((size_t)1, order[1]);
+		}
+
+		TEST_METHOD(PrerequisitesComeFirst)
+		{
+			// c depends on b, which depends on a, given in reverse order
+			TaskDefinition tasks[3];
+			tasks[0].SetName(L"c");
+			tasks[0].AddDependency(L"b");
+			tasks[1].SetName(L"b");
+			tasks[1].AddDependency(L"a");
+			tasks[2].SetName(L"a");
+
+			std::vector<size_t> order;
+			Assert::IsTrue(SortByDependencies(tasks, 3, order));
+			Assert::AreEqual((size_t)3, order.size());
+			Assert::AreEqual((size_t)2, order[0]);
+			Assert::AreEqual((size_t)1, order[1]);
+			Assert::AreEqual((size_t)0, order[2]);
+		}
+
+		TEST_METHOD(NamesIgnoreCase)
+		{
+			// b depends on A, given as a
+			TaskDefinition tasks[2];
+			tasks[0].SetName(L"B");
+			tasks[0].AddDependency(L"a");
+			tasks[1].SetName(L"A");
+
+			std::vector<size_t> order;
+			Assert::IsTrue(SortByDependencies(tasks, 2, order));
+			Assert::AreEqual((size_t)2, order.size());
+			Assert::AreEqual((size_t)1, order[0]);
+			Assert::AreEqual((size_t)0, order[1]);
+		}
+
+		TEST_METHOD(UnknownDependenciesAreIgnored)
+		{
+			TaskDefinition task;
+			task.SetName(L"a");
+			task.AddDependency(L"already registered");
+
+			std::vector<size_t> order;
+			Assert::IsTrue(SortByDependencies(&task, 1, order));
+			Assert::AreEqual((size_t)1, order.size());
+		}
+
+		TEST_METHOD(CycleIsDetected)
+		{
+			// a and b depend on each other, c depends on b, and d is independent
+			TaskDefinition tasks[4];
+			tasks[0].SetName(L"a");
+			tasks[0].AddDependency(L"b");
+			tasks[1].SetName(L"b");
+			tasks[1].AddDependency(L"a");
+			tasks[2].SetName(L"c");
+			tasks[2].AddDependency(L"b");
+			tasks[3].SetName(L"d");
+
+			std::vector<size_t> order;
+			Assert::IsFalse(SortByDependencies(tasks, 4, order));
+			Assert::AreEqual((size_t)1, order.size());
+			Assert::AreEqual((size_t)3, order[0]);
+		}
+
+		TEST_METHOD(SelfDependencyIsACycle)
+		{
+			TaskDefinition task;
+			task.SetName(L"a");
+			task.AddDependency(L"a");
+
+			std::vector<size_t> order;
+			Assert::IsFalse(SortByDependencies(&task, 1, order));
+			Assert::AreEqual((size_t)0, order.size());
+		}
+	};
+}
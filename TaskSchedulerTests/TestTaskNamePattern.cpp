@@ -0,0 +1,40 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestTaskNamePattern)
+	{
+	public:
+
+		TEST_METHOD(ExactName)
+		{
+			Assert::IsTrue(MatchTaskName(L"service-1", L"service-1"));
+			Assert::IsTrue(MatchTaskName(L"Service-1", L"SERVICE-1"));
+			Assert::IsFalse(MatchTaskName(L"service-1", L"service-10"));
+			Assert::IsFalse(MatchTaskName(L"service-10", L"service-1"));
+			Assert::IsFalse(MatchTaskName(L"", L"service"));
+		}
+
+		TEST_METHOD(Prefix)
+		{
+			Assert::IsTrue(MatchTaskName(L"service-*", L"service-"));
+			Assert::IsTrue(MatchTaskName(L"service-*", L"service-12345"));
+			Assert::IsFalse(MatchTaskName(L"service-*", L"other-service-1"));
+			Assert::IsTrue(MatchTaskName(L"*", L""));
+			Assert::IsTrue(MatchTaskName(L"*", L"anything"));
+		}
+
+		TEST_METHOD(Glob)
+		{
+			Assert::IsTrue(MatchTaskName(L"*-nightly", L"service-1-nightly"));
+			Assert::IsFalse(MatchTaskName(L"*-nightly", L"service-1-nightly-2"));
+			Assert::IsTrue(MatchTaskName(L"service-?-*ly", L"service-1-nightly"));
+			Assert::IsFalse(MatchTaskName(L"service-?-*", L"service-12-nightly"));
+			Assert::IsTrue(MatchTaskName(L"a*b*c", L"aXbYbZc"));
+			Assert::IsFalse(MatchTaskName(L"a*b*c", L"aXbYbZ"));
+		}
+	};
+}
@@ -0,0 +1,157 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestTaskSnapshot)
+	{
+	public:
+
+		TEST_METHOD(PublishAndFind)
+		{
+			TaskSnapshotWriter writer;
+			Assert::IsTrue(writer.Create(L"Local\\TaskSchedulerTestsSnapshot", 1024 * 1024));
+
+			TaskSnapshotReader reader;
+			Assert::IsTrue(reader.Open(L"Local\\TaskSchedulerTestsSnapshot"));
+			Assert::AreEqual(0u, reader.Size());
+
+			TaskTable table;
+			std::vector<TaskSnapshotEntry> entries;
+			for (int i = 0; i < 1000; i++) {
+				TaskDefinition task;
+				task.SetName((L"Task" + std::to_wstring(i)).c_str());
+				table.Insert(task);
+
+				TaskSnapshotEntry entry;
+				entry.nextRun = i * 60;
+				entry.lastResult = i;
+				entries.push_back(entry);
+			}
+			Assert::IsTrue(writer.Publish(table, entries.data()));
+			Assert::AreEqual(1000u, reader.Size());
+
+			TaskSnapshotEntry found;
+			Assert::IsTrue(reader.Find(L"Task567", found));
+			Assert::AreEqual((int64_t)567 * 60, found.nextRun);
+			Assert::AreEqual(567, found.lastResult);
+			Assert::IsFalse(reader.Find(L"Task1000", found));
+
+			// A new snapshot replaces the previous one
+			table.Remove(L"Task567");
+			Assert::IsTrue(writer.Publish(table, entries.data()));
+			Assert::AreEqual(999u, reader.Size());
+			Assert::IsFalse(reader.Find(L"Task567", found));
+		}
+
+		TEST_METHOD(FindIgnoresCase)
+		{
+			TaskSnapshotWriter writer;
+			Assert::IsTrue(writer.Create(L"Local\\TaskSchedulerTestsCaseSnapshot", 64 * 1024));
+			TaskSnapshotReader reader;
+			Assert::IsTrue(reader.Open(L"Local\\TaskSchedulerTestsCaseSnapshot"));
+
+			TaskTable table;
+			TaskDefinition task;
+			task.SetName(L"Nightly-Report");
+			table.Insert(task);
+			TaskSnapshotEntry entry = { 3600, 0 };
+			Assert::IsTrue(writer.Publish(table, &entry));
+
+			TaskSnapshotEntry found;
+			Assert::IsTrue(reader.Find(L"nightly-report", found));
+			Assert::AreEqual((int64_t)3600, found.nextRun);
+			Assert::IsTrue(reader.Find(L"NIGHTLY-REPORT", found));
+			Assert::IsFalse(reader.Find(L"nightly-repor", found));
+		}
+
+		TEST_METHOD(WriterDiedWhilePublishing)
+		{
+			const wchar_t *name = L"Local\\TaskSchedulerTestsDeadSnapshot";
+			TaskTable table;
+			TaskDefinition task;
+			task.SetName(L"Task");
+			table.Insert(task);
+			TaskSnapshotEntry entry = { 60, 1 };
+
+			TaskSnapshotReader reader;
+			{
+				TaskSnapshotWriter writer;
+				Assert::IsTrue(writer.Create(name, 64 * 1024));
+				Assert::IsTrue(writer.Publish(table, &entry));
+				Assert::IsTrue(reader.Open(name));
+
+				// Leave the sequence odd, as if the writer died part way through publishing.
+				// The sequence is the third 32-bit field of the shared memory.
+				HANDLE mapping = OpenFileMappingW(FILE_MAP_WRITE, FALSE, name);
+				Assert::IsTrue(mapping != NULL);
+				uint32_t *header = (uint32_t *)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+				Assert::IsTrue(header != NULL);
+				header[2] |= 1;
+				UnmapViewOfFile(header);
+				CloseHandle(mapping);
+			}
+
+			// Readers give up rather than waiting forever
+			TaskSnapshotEntry found;
+			Assert::IsFalse(reader.Find(L"Task", found));
+			Assert::IsTrue(reader.TimedOut());
+			Assert::AreEqual(0u, reader.Size());
+			Assert::IsTrue(reader.TimedOut());
+
+			// A new writer makes the snapshot readable again, and publishes over it
+			TaskSnapshotWriter writer;
+			Assert::IsTrue(writer.Create(name, 64 * 1024));
+			Assert::IsTrue(reader.Find(L"Task", found));
+			Assert::IsFalse(reader.TimedOut());
+			entry.lastResult = 2;
+			Assert::IsTrue(writer.Publish(table, &entry));
+			Assert::IsTrue(reader.Find(L"Task", found));
+			Assert::AreEqual(2, found.lastResult);
+		}
+
+		TEST_METHOD(PublishTooLarge)
+		{
+			TaskSnapshotWriter writer;
+			Assert::IsTrue(writer.Create(L"Local\\TaskSchedulerTestsSmallSnapshot", 256));
+
+			TaskTable table;
+			std::vector<TaskSnapshotEntry> entries(100);
+			for (int i = 0; i < 100; i++) {
+				TaskDefinition task;
+				task.SetName((L"Task" + std::to_wstring(i)).c_str());
+				table.Insert(task);
+			}
+			Assert::IsFalse(writer.Publish(table, entries.data()));
+		}
+
+		TEST_METHOD(OpenMissing)
+		{
+			TaskSnapshotReader reader;
+			Assert::IsFalse(reader.Open(L"Local\\TaskSchedulerTestsMissingSnapshot"));
+			TaskSnapshotEntry found;
+			Assert::IsFalse(reader.Find(L"Task", found));
+		}
+
+		TEST_METHOD(OpenNotASnapshot)
+		{
+			HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, 4096,
+				L"Local\TaskSchedulerTestsNotASnapshot");
+			Assert::IsTrue(mapping != NULL);
+
+			TaskSnapshotReader reader;
+			Assert::IsFalse(reader.Open(L"Local\TaskSchedulerTestsNotASnapshot"));
+			TaskSnapshotEntry found;
+			Assert::IsFalse(reader.Find(L"Task", found));
+			CloseHandle(mapping);
+
+			// The reader is left closed, so it can open another snapshot
+			TaskSnapshotWriter writer;
+			Assert::IsTrue(writer.Create(L"Local\TaskSchedulerTestsSnapshot", 4096));
+			Assert::IsTrue(reader.Open(L"Local\TaskSchedulerTestsSnapshot"));
+			Assert::AreEqual(0u, reader.Size());
+		}
+	};
+}
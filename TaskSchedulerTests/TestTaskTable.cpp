@@ -0,0 +1,197 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestTaskTable)
+	{
+	public:
+
+		static TaskDefinition MakeTask(const wchar_t *name, const TimeSpec &time)
+		{
+			static const wchar_t* ARGV[] = { L"--mode", L"nightly run" };
+			TaskDefinition task;
+			task.SetName(name);
+			task.SetExecutable(L"C:\\svc.exe");
+			task.SetArguments(ARGV, 2);
+			task.SetStartDate(DateSpec(2017, 8, 17));
+			task.SetDailyStartTime(time);
+			return task;
+		}
+
+		TEST_METHOD(EmptyTable)
+		{
+			TaskTable table;
+			Assert::AreEqual(0u, table.Size());
+			Assert::AreEqual(TaskTable::INVALID_ROW, table.Find(L"missing"));
+			Assert::AreEqual(0.0, table.GetBytesPerTask());
+			Assert::IsFalse(table.Remove(L"missing"));
+		}
+
+		TEST_METHOD(InsertAndFind)
+		{
+			TaskTable table;
+			Assert::AreEqual(0u, table.Insert(MakeTask(L"a", TimeSpec(1, 2, 3))));
+			Assert::AreEqual(1u, table.Insert(MakeTask(L"b", TimeSpec(4, 5, 6))));
+
+			uint32_t row = table.Find(L"b");
+			Assert::AreEqual(1u, row);
+			Assert::AreEqual(L"b", table.GetName(row));
+			Assert::AreEqual(L"C:\\svc.exe", table.GetExecutable(row));
+			Assert::AreEqual(L"--mode \"nightly run\"", table.GetArguments(row));
+			Assert::AreEqual(2017, (int)table.GetStartDate(row).GetYear());
+			Assert::AreEqual(8, (int)table.GetStartDate(row).GetMonth());
+			Assert::AreEqual(17, (int)table.GetStartDate(row).GetDay());
+			Assert::AreEqual(0, (int)table.GetEndDate(row).GetYear());
+			Assert::AreEqual(4, (int)table.GetDailyStartTime(row).GetHour());
+			Assert::AreEqual(5, (int)table.GetDailyStartTime(row).GetMinute());
+			Assert::AreEqual(6, (int)table.GetDailyStartTime(row).GetSecond());
+
+			DailyScheduleColumns columns = table.GetScheduleColumns();
+			Assert::AreEqual((size_t)2, columns.count);
+			Assert::AreEqual(DateToDays(DateSpec(2017, 8, 17)), columns.startDays[row]);
+			Assert::AreEqual(NO_END_DAY, columns.endDays[row]);
+			Assert::AreEqual(4 * 3600 + 5 * 60 + 6, columns.startSeconds[row]);
+		}
+
+		TEST_METHOD(InsertReplacesExisting)
+		{
+			TaskTable table;
+			table.Insert(MakeTask(L"a", TimeSpec(1, 0, 0)));
+			Assert::AreEqual(0u, table.Insert(MakeTask(L"a", TimeSpec(2, 0, 0))));
+			Assert::AreEqual(1u, table.Size());
+			Assert::AreEqual(2, (int)table.GetDailyStartTime(0).GetHour());
+		}
+
+		TEST_METHOD(RemoveMovesLastRow)
+		{
+			TaskTable table;
+			table.Insert(MakeTask(L"a", TimeSpec(1, 0, 0)));
+			table.Insert(MakeTask(L"b", TimeSpec(2, 0, 0)));
+			table.Insert(MakeTask(L"c", TimeSpec(3, 0, 0)));
+
+			Assert::IsTrue(table.Remove(L"a"));
+			Assert::AreEqual(2u, table.Size());
+			Assert::AreEqual(TaskTable::INVALID_ROW, table.Find(L"a"));
+			Assert::AreEqual(0u, table.Find(L"c"));
+			Assert::AreEqual(3, (int)table.GetDailyStartTime(0).GetHour());
+
+			// Inserting a removed name again should work
+			Assert::AreEqual(2u, table.Insert(MakeTask(L"a", TimeSpec(4, 0, 0))));
+			Assert::AreEqual(2u, table.Find(L"a"));
+		}
+
+		TEST_METHOD(GetDefinition)
+		{
+			TaskTable table;
+			table.Insert(MakeTask(L"a", TimeSpec(1, 2, 3)));
+
+			TaskDefinition task = table.GetDefinition(0);
+			Assert::AreEqual(L"a", task.GetName().c_str());
+			Assert::AreEqual(L"C:\\svc.exe", task.GetExecutable().c_str());
+			Assert::AreEqual(L"--mode \"nightly run\"", task.GetArguments());
+			Assert::AreEqual(3, (int)task.GetDailyStartTime().GetSecond());
+		}
+
+		TEST_METHOD(ManyTasks)
+		{
+			TaskTable table;
+			TaskDefinition task = MakeTask(L"", TimeSpec());
+			for (int i = 0; i < 10000; i++) {
+				task.SetName((L"task-" + std::to_wstring(i)).c_str());
+				table.Insert(task);
+			}
+
+			Assert::AreEqual(10000u, table.Size());
+			for (int i = 0; i < 10000; i++) {
+				Assert::AreEqual((uint32_t)i, table.Find((L"task-" + std::to_wstring(i)).c_str()));
+			}
+
+			// The executable and arguments are shared, so the cost per task should be small
+			Assert::IsTrue(table.GetBytesPerTask() < 128.0);
+		}
+
+		TEST_METHOD(Clear)
+		{
+			TaskTable table;
+			table.Insert(MakeTask(L"a", TimeSpec()));
+			table.Clear();
+			Assert::AreEqual(0u, table.Size());
+			Assert::AreEqual(TaskTable::INVALID_ROW, table.Find(L"a"));
+		}
+
+		TEST_METHOD(ContentHash)
+		{
+			TaskTable table;
+			uint32_t a = table.Insert(MakeTask(L"a", TimeSpec(1, 0, 0)));
+			uint32_t b = table.Insert(MakeTask(L"b", TimeSpec(1, 0, 0)));
+			uint32_t c = table.Insert(MakeTask(L"c", TimeSpec(2, 0, 0)));
+
+			TaskDefinition limited = MakeTask(L"d", TimeSpec(1, 0, 0));
+			TaskSettings settings;
+			settings.executionTimeLimit = 60;
+			limited.SetSettings(settings);
+			uint32_t d = table.Insert(limited);
+
+			TaskDefinition urgent = MakeTask(L"e", TimeSpec(1, 0, 0));
+			settings = TaskSettings();
+			settings.priority = TaskSettings::HIGHEST_PRIORITY;
+			urgent.SetSettings(settings);
+			uint32_t e = table.Insert(urgent);
+
+			// The name is not part of the content, but the schedule and settings are
+			Assert::AreEqual(table.GetContentHash(a), table.GetContentHash(b));
+			Assert::AreNotEqual(table.GetContentHash(a), table.GetContentHash(c));
+			Assert::AreNotEqual(table.GetContentHash(a), table.GetContentHash(d));
+			Assert::AreNotEqual(table.GetContentHash(a), table.GetContentHash(e));
+		}
+
+		TEST_METHOD(Diff)
+		{
+			TaskTable current, next;
+			current.Insert(MakeTask(L"same", TimeSpec(1, 0, 0)));
+			current.Insert(MakeTask(L"changed", TimeSpec(1, 0, 0)));
+			current.Insert(MakeTask(L"removed", TimeSpec(1, 0, 0)));
+
+			next.Insert(MakeTask(L"added", TimeSpec(1, 0, 0)));
+			next.Insert(MakeTask(L"changed", TimeSpec(2, 0, 0)));
+			next.Insert(MakeTask(L"same", TimeSpec(1, 0, 0)));
+
+			TaskTableDiff diff;
+			DiffTaskTables(current, next, diff);
+
+			Assert::AreEqual((size_t)1, diff.inserted.size());
+			Assert::AreEqual(L"added", next.GetName(diff.inserted[0]));
+			Assert::AreEqual((size_t)1, diff.updated.size());
+			Assert::AreEqual(L"changed", next.GetName(diff.updated[0]));
+			Assert::AreEqual((size_t)1, diff.deleted.size());
+			Assert::AreEqual(L"removed", current.GetName(diff.deleted[0]));
+		}
+
+		TEST_METHOD(DiffIgnoresCase)
+		{
+			// The task service treats these as the same task, so nothing needs to be registered or deleted
+			TaskTable current, next;
+			current.Insert(MakeTask(L"Foo", TimeSpec(1, 0, 0)));
+			current.Insert(MakeTask(L"Bar", TimeSpec(1, 0, 0)));
+			next.Insert(MakeTask(L"foo", TimeSpec(1, 0, 0)));
+			next.Insert(MakeTask(L"BAR", TimeSpec(2, 0, 0)));
+
+			TaskTableDiff diff;
+			DiffTaskTables(current, next, diff);
+			Assert::AreEqual((size_t)0, diff.inserted.size());
+			Assert::AreEqual((size_t)0, diff.deleted.size());
+			Assert::AreEqual((size_t)1, diff.updated.size());
+			Assert::AreEqual(L"BAR", next.GetName(diff.updated[0]));
+
+			// Inserting again with another spelling replaces the row, and takes the new spelling
+			Assert::AreEqual(current.Find(L"FOO"), current.Insert(MakeTask(L"fOO", TimeSpec(1, 0, 0))));
+			Assert::AreEqual(2u, current.Size());
+			Assert::AreEqual(L"fOO", current.GetName(current.Find(L"foo")));
+			Assert::IsTrue(current.Remove(L"FOO"));
+			Assert::AreEqual(TaskTable::INVALID_ROW, current.Find(L"foo"));
+		}
+	};
+}
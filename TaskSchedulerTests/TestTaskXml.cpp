@@ -0,0 +1,154 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestTaskXml)
+	{
+	public:
+
+		static TaskDefinition MakeTask(const std::wstring &name)
+		{
+			TaskDefinition task;
+			task.SetName(name.c_str());
+			task.SetStartDate(DateSpec(2017, 11, 1));
+			task.SetEndDate(DateSpec(2018, 5, 29));
+			task.SetDailyStartTime(TimeSpec(2, 30, 0));
+			task.SetExecutable(L"C:\\Program Files\\svc.exe");
+			task.SetArgumentString(L"--mode \"nightly & weekly\" <all>");
+			return task;
+		}
+
+		TEST_METHOD(RoundTripDaily)
+		{
+			TaskDefinition task = MakeTask(L"Nightly");
+			std::wstring xml;
+			FormatTaskXml(xml, task);
+			Assert::IsTrue(xml.find(L"&quot;nightly &amp; weekly&quot; &lt;all&gt;") != std::wstring::npos);
+
+			TaskDefinition parsed;
+			Assert::IsTrue(ParseTaskXml(parsed, xml.c_str(), xml.size()));
+			Assert::AreEqual(L"Nightly", parsed.GetName().c_str());
+			Assert::IsTrue(parsed.GetStartDate() == task.GetStartDate());
+			Assert::IsTrue(parsed.GetEndDate() == task.GetEndDate());
+			Assert::IsTrue(parsed.GetDailyStartTime() == task.GetDailyStartTime());
+			Assert::AreEqual(task.GetExecutable().c_str(), parsed.GetExecutable().c_str());
+			Assert::AreEqual(task.GetArguments(), parsed.GetArguments());
+			Assert::IsTrue(parsed.GetSettings() == task.GetSettings());
+			Assert::IsTrue(parsed.GetDependencies().empty());
+		}
+
+		TEST_METHOD(RoundTripDependenciesAndSettings)
+		{
+			TaskDefinition task = MakeTask(L"Report");
+			task.AddDependency(L"Extract");
+			task.AddDependency(L"Load");
+			TaskSettings settings;
+			settings.executionTimeLimit = 90061;
+			settings.instancesPolicy = INSTANCES_QUEUE;
+			settings.startWhenAvailable = false;
+			settings.priority = 2;
+			task.SetSettings(settings);
+
+			std::wstring xml;
+			FormatTaskXml(xml, task);
+			TaskDefinition parsed;
+			Assert::IsTrue(ParseTaskXml(parsed, xml.c_str(), xml.size()));
+			Assert::AreEqual((size_t)2, parsed.GetDependencies().size());
+			Assert::AreEqual(L"Extract", parsed.GetDependencies()[0].c_str());
+			Assert::AreEqual(L"Load", parsed.GetDependencies()[1].c_str());
+			Assert::IsTrue(parsed.GetStartDate() == task.GetStartDate());
+			Assert::IsTrue(parsed.GetSettings() == settings);
+		}
+
+		TEST_METHOD(ParseInvalid)
+		{
+			TaskDefinition parsed;
+			Assert::IsFalse(ParseTaskXml(parsed, L"", 0));
+			const wchar_t noAction[] = L"<Task><RegistrationInfo><URI>\\A</URI></RegistrationInfo></Task>";
+			Assert::IsFalse(ParseTaskXml(parsed, noAction, wcslen(noAction)));
+		}
+
+		TEST_METHOD(CharacterReferences)
+		{
+			// A character beyond the basic multilingual plane becomes a surrogate pair
+			const wchar_t xml[] = L"<Task><RegistrationInfo><URI>\\Caf&#xE9;&#128512;</URI></RegistrationInfo>"
+				L"<Actions><Exec><Command>a.exe</Command></Exec></Actions></Task>";
+			TaskDefinition parsed;
+			Assert::IsTrue(ParseTaskXml(parsed, xml, wcslen(xml)));
+			Assert::AreEqual(L"Caf\xE9\xD83D\xDE00", parsed.GetName().c_str());
+
+			// Surrogates and values beyond the last code point aren't characters
+			const wchar_t surrogate[] = L"<Task><RegistrationInfo><URI>\\A&#xD800;</URI></RegistrationInfo>"
+				L"<Actions><Exec><Command>a.exe</Command></Exec></Actions></Task>";
+			Assert::IsFalse(ParseTaskXml(parsed, surrogate, wcslen(surrogate)));
+			const wchar_t tooLarge[] = L"<Task><RegistrationInfo><URI>\\A</URI></RegistrationInfo>"
+				L"<Actions><Exec><Command>a.exe</Command><Arguments>&#x110000;</Arguments></Exec></Actions></Task>";
+			Assert::IsFalse(ParseTaskXml(parsed, tooLarge, wcslen(tooLarge)));
+		}
+
+		TEST_METHOD(NameOfServiceTask)
+		{
+			// As exported from the task service, with a COM handler rather than an exec action
+			const wchar_t xml[] =
+				L"<?xml version=\"1.0\" encoding=\"UTF-16\"?>\n"
+				L"<Task version=\"1.3\" xmlns=\"http://schemas.microsoft.com/windows/2004/02/mit/task\">\n"
+				L"  <RegistrationInfo>\n"
+				L"    <Author>Microsoft Corporation</Author>\n"
+				L"    <URI>\\Microsoft\\Windows\\Defrag\\ScheduledDefrag</URI>\n"
+				L"  </RegistrationInfo>\n"
+				L"  <Principals>\n"
+				L"    <Principal id=\"LocalSystem\"><UserId>S-1-5-18</UserId></Principal>\n"
+				L"  </Principals>\n"
+				L"  <Actions Context=\"LocalSystem\">\n"
+				L"    <ComHandler>\n"
+				L"      <ClassId>{A8C3D5C0-A2F1-4B73-8D5A-7B6E5C3A1F00}</ClassId>\n"
+				L"    </ComHandler>\n"
+				L"  </Actions>\n"
+				L"</Task>\n";
+
+			std::wstring name;
+			Assert::IsTrue(GetTaskXmlName(name, xml, wcslen(xml)));
+			Assert::AreEqual(L"ScheduledDefrag", name.c_str());
+
+			// Only the name can be read, the rest isn't in the subset ParseTaskXml understands
+			TaskDefinition parsed;
+			Assert::IsFalse(ParseTaskXml(parsed, xml, wcslen(xml)));
+
+			const wchar_t noName[] = L"<Task><Actions><ComHandler/></Actions></Task>";
+			Assert::IsFalse(GetTaskXmlName(name, noName, wcslen(noName)));
+		}
+
+		TEST_METHOD(WriteAndReadFile)
+		{
+			wchar_t path[MAX_PATH];
+			Assert::IsTrue(GetTempPathW(MAX_PATH, path) != 0);
+			std::wstring file = std::wstring(path) + L"TaskSchedulerTestsTasks.xml";
+
+			// Enough tasks to span several reads
+			const int count = 500;
+			TaskXmlWriter writer;
+			Assert::IsTrue(writer.Open(file.c_str()));
+			for (int i = 0; i < count; i++) {
+				Assert::IsTrue(writer.Write(MakeTask(L"Task" + std::to_wstring(i))));
+			}
+			Assert::IsTrue(writer.Close());
+
+			TaskXmlReader reader;
+			Assert::IsTrue(reader.Open(file.c_str()));
+			std::wstring xml;
+			int read = 0;
+			while (reader.Next(xml)) {
+				TaskDefinition parsed;
+				Assert::IsTrue(ParseTaskXml(parsed, xml.c_str(), xml.size()));
+				Assert::AreEqual((L"Task" + std::to_wstring(read)).c_str(), parsed.GetName().c_str());
+				read++;
+			}
+			Assert::IsFalse(reader.Failed());
+			Assert::AreEqual(count, read);
+			DeleteFileW(file.c_str());
+		}
+	};
+}
@@ -2,6 +2,7 @@
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace task_scheduler;
+using namespace task_scheduler::literals;
 
 namespace TaskSchedulerTests
 {
@@ -52,5 +53,32 @@ namespace TaskSchedulerTests
 			Assert::AreEqual(L"2018-01-14T13:05:33", buffer);
 		}
 
+		TEST_METHOD(ConstantExpression)
+		{
+			constexpr TimeSpec spec(8, 23, 15);
+			static_assert(spec.GetTotalSeconds() == 30195, "Expected constexpr total seconds");
+			static_assert(spec - TimeSpec(6, 7, 10) == 8165, "Expected constexpr subtraction");
+			static_assert(TimeSpec(24, 60, 60) == TimeSpec(), "Expected invalid values to default to 0");
+		}
+
+		TEST_METHOD(TimeLiteral)
+		{
+			constexpr TimeSpec spec = "02:30:05"_time;
+			static_assert(spec == TimeSpec(2, 30, 5), "Expected 02:30:05");
+			Assert::AreEqual(2, (int)spec.GetHour());
+			Assert::AreEqual(30, (int)spec.GetMinute());
+			Assert::AreEqual(5, (int)spec.GetSecond());
+		}
+
+		TEST_METHOD(TimeLiteralInvalid)
+		{
+			// Evaluated at runtime, so that these throw instead of failing to compile
+			Assert::ExpectException<std::invalid_argument>([] { return "2:30:00"_time; });
+			Assert::ExpectException<std::invalid_argument>([] { return "02-30-00"_time; });
+			Assert::ExpectException<std::invalid_argument>([] { return "0a:30:00"_time; });
+			Assert::ExpectException<std::out_of_range>([] { return "24:00:00"_time; });
+			Assert::ExpectException<std::out_of_range>([] { return "23:60:00"_time; });
+		}
+
 	};
 }
\ No newline at end of file
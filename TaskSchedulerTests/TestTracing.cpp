@@ -0,0 +1,58 @@
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace task_scheduler;
+
+namespace TaskSchedulerTests
+{
+	TEST_CLASS(TestTracing)
+	{
+	public:
+
+		TEST_METHOD(DisabledRecordsNothing)
+		{
+			std::string trace;
+			FormatTrace(trace);
+
+			EnableTracing(false);
+			{
+				TASKSCHEDULER_TRACE_SPAN("DisabledSpan");
+			}
+
+			FormatTrace(trace);
+			Assert::IsTrue(trace.find("DisabledSpan") == std::string::npos);
+		}
+
+		TEST_METHOD(EnabledRecordsSpans)
+		{
+			EnableTracing(true);
+			{
+				TASKSCHEDULER_TRACE_SPAN("Outer");
+				TASKSCHEDULER_TRACE_SPAN("Inner");
+			}
+			EnableTracing(false);
+
+			std::string trace;
+			FormatTrace(trace);
+			Assert::IsTrue(trace.find("{\"traceEvents\":[") == 0);
+			Assert::IsTrue(trace.find("\"name\":\"Outer\"") != std::string::npos);
+			Assert::IsTrue(trace.find("\"name\":\"Inner\"") != std::string::npos);
+			Assert::IsTrue(trace.find("\"ph\":\"X\"") != std::string::npos);
+		}
+
+		TEST_METHOD(FormatDiscardsSpans)
+		{
+			EnableTracing(true);
+			{
+				TASKSCHEDULER_TRACE_SPAN("Once");
+			}
+			EnableTracing(false);
+
+			std::string trace;
+			FormatTrace(trace);
+			Assert::IsTrue(trace.find("Once") != std::string::npos);
+			FormatTrace(trace);
+			Assert::IsTrue(trace.find("Once") == std::string::npos);
+		}
+	};
+}